@@ -0,0 +1,45 @@
+/**
+ * Allocation counter
+ *
+ * Replaces the global operator new and delete with versions that count
+ * every allocation, so a program can check how often it reaches the global
+ * allocator (see arena.h). The benchmark always includes it, and
+ * instrumented builds include it through instrument.h; the normal build
+ * does not.
+ *
+ * The replacements are ordinary definitions, so include this header from
+ * exactly one translation unit of a program.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_ALLOCCOUNT_H
+#define PAGER_ALLOCCOUNT_H
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<long long> allocationCount(0);  // Calls into the global allocator
+
+void *operator new(size_t bytes)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *block = std::malloc(bytes ? bytes : 1))
+        return block;
+    throw std::bad_alloc();
+}
+
+// Not inlined, so the compiler does not pair the free() with a new expression
+__attribute__((noinline)) void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+    operator delete(block);
+}
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * Trace analysis
+ *
+ * Statistics for tuning, independent of any one algorithm: the LRU stack
+ * distance and inter-reference gap distributions, the number of distinct
+ * pages and how many of them are used only once.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_ANALYZE_H
+#define PAGER_ANALYZE_H
+
+#include <vector>
+
+#include "arena.h"
+#include "instrument.h"
+#include "mrc.h"
+#include "remap.h"
+
+/**
+ * @brief Results of analyzeTrace().
+ *
+ * Histograms use power-of-two buckets: bucket k counts values in
+ * [2^k, 2^(k+1)).
+ */
+
+struct TraceStats {
+    long long references;                   // Number of references
+    int distinct;                           // Number of distinct pages
+    int oneHitWonders;                      // Pages referenced exactly once
+    std::vector<long long> distanceHist;    // Re-references by LRU stack distance
+    std::vector<long long> gapHist;         // Re-references by references since the last use
+};
+
+/**
+ * @brief Bucket of a positive value in a power-of-two histogram.
+ */
+
+inline int log2Bucket(long long value)
+{
+    return 63 - __builtin_clzll(value);
+}
+
+/**
+ * @brief Compute trace statistics in one pass.
+ *
+ * The trace is first remapped to dense pages so per-page state lives in
+ * flat arrays. Stack distances come from a Fenwick tree marking the
+ * latest use of each page, as in stackDistanceFaults(), except that the
+ * tree is indexed by a use counter that is renumbered whenever it fills.
+ * The tree therefore needs room for about twice the distinct pages rather
+ * than the whole trace. O(n log U) time; O(n) memory for the remapped
+ * copy of the trace, plus O(U) for everything else.
+ *
+ * @param refs[]   Array of page references
+ * @param refCount Number of page references
+ *
+ * @return The statistics
+ */
+
+inline TraceStats analyzeTrace(const int refs[],
+                               int refCount)
+{
+    RunVector<int> dense, original;
+    int universe = remapTrace(refs, refCount, dense, original);
+
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    TraceStats stats;
+    stats.references = refCount;
+    stats.distinct = universe;
+    stats.oneHitWonders = universe;
+    stats.distanceHist.assign(32, 0);
+    stats.gapHist.assign(32, 0);
+
+    int capacity = 2 * universe + 16;           // Positions before renumbering
+    FenwickTree latest(capacity);               // 1 at the position of each page's latest use
+    RunVector<int> positionOf(universe, -1);    // Page -> position of its latest use
+    RunVector<int> pageAt(capacity, -1);        // Position -> page used there
+    RunVector<int> lastUse(universe, -1);       // Page -> index of its latest reference
+    RunVector<char> reused(universe, 0);        // Page -> referenced more than once
+    int next = 0;                               // Next free position
+
+    for (int t = 0; t < refCount; t++) {
+        int page = dense[t];
+
+        if (next == capacity) {
+            // Renumber the live positions 0..U-1, keeping their order
+            latest = FenwickTree(capacity);
+            int live = 0;
+            for (int pos = 0; pos < capacity; pos++) {
+                int p = pageAt[pos];
+                pageAt[pos] = -1;
+                if (p != -1 && positionOf[p] == pos) {
+                    positionOf[p] = live;
+                    pageAt[live] = p;
+                    latest.add(live, 1);
+                    live++;
+                }
+            }
+            next = live;
+        }
+
+        if (lastUse[page] != -1) {
+            int prev = positionOf[page];
+            int distance = latest.prefix(next) - latest.prefix(prev + 1) + 1;
+            stats.distanceHist[log2Bucket(distance)]++;
+            stats.gapHist[log2Bucket(t - lastUse[page])]++;
+            latest.add(prev, -1);
+
+            if (!reused[page]) {
+                reused[page] = 1;
+                stats.oneHitWonders--;
+            }
+        }
+
+        lastUse[page] = t;
+        positionOf[page] = next;
+        pageAt[next] = page;
+        latest.add(next, 1);
+        next++;
+    }
+
+    return stats;
+}
+
+#endif
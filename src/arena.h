@@ -0,0 +1,228 @@
+/**
+ * Run arenas
+ *
+ * A batch sweep builds and throws away thousands of pagers, each with its
+ * frame arrays, indices and lists. Inside an ArenaScope, every container
+ * of per-run state (RunVector, RunHashMap) takes its memory from the
+ * scope's RunArena instead of the global allocator, and reset() hands all
+ * of it back at once between runs.
+ *
+ * The arena carves power-of-two blocks from large chunks. A freed block
+ * goes on a free list for its size and is handed out again, so a growing
+ * vector or a hash map replacing its nodes reuses memory rather than
+ * piling it up: once a run has warmed up it makes no calls into the global
+ * allocator, and after the first run of a sweep neither does anything
+ * else, as long as later runs are no bigger.
+ *
+ * Containers built outside any scope use the global allocator as usual.
+ * Everything allocated from an arena must be destroyed before the arena is
+ * reset or destroyed.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_ARENA_H
+#define PAGER_ARENA_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+const size_t ARENA_CHUNK_BYTES = 1 << 20;  // Least memory the arena asks for at once
+const int ARENA_MIN_SHIFT = 4;             // Smallest block: 16 bytes, aligned for any type
+const int ARENA_CLASSES = 48;              // Block sizes 2^4 .. 2^51
+
+/**
+ * @brief Monotonic allocator with per-size free lists and O(1) reset.
+ */
+
+class RunArena {
+public:
+    RunArena() : current(0), at(nullptr), end(nullptr)
+    {
+        for (int c = 0; c < ARENA_CLASSES; c++)
+            freeList[c] = nullptr;
+    }
+
+    RunArena(const RunArena &) = delete;
+    RunArena &operator=(const RunArena &) = delete;
+
+    ~RunArena()
+    {
+        for (size_t i = 0; i < chunks.size(); i++)
+            ::operator delete(chunks[i].first);
+    }
+
+    void *allocate(size_t bytes)
+    {
+        int c = sizeClass(bytes);
+        if (freeList[c]) {
+            void *block = freeList[c];
+            freeList[c] = *static_cast<void **>(block);
+            return block;
+        }
+
+        size_t size = (size_t)1 << (c + ARENA_MIN_SHIFT);
+        while ((size_t)(end - at) < size)
+            nextChunk(size);
+        void *block = at;
+        at += size;
+        return block;
+    }
+
+    void deallocate(void *block,
+                    size_t bytes)
+    {
+        int c = sizeClass(bytes);
+        *static_cast<void **>(block) = freeList[c];
+        freeList[c] = block;
+    }
+
+    /**
+     * @brief Make all the memory available again, keeping the chunks.
+     */
+
+    void reset()
+    {
+        for (int c = 0; c < ARENA_CLASSES; c++)
+            freeList[c] = nullptr;
+        current = 0;
+        at = chunks.empty() ? nullptr : chunks[0].first;
+        end = chunks.empty() ? nullptr : chunks[0].first + chunks[0].second;
+    }
+
+    /**
+     * @brief Bytes obtained from the global allocator so far.
+     */
+
+    size_t reserved() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < chunks.size(); i++)
+            total += chunks[i].second;
+        return total;
+    }
+
+private:
+    std::vector<std::pair<char *, size_t> > chunks;     // Every chunk, in use order
+    size_t current;                                     // Chunk being carved
+    char *at;                                           // Next free byte of it
+    char *end;                                          // End of it
+    void *freeList[ARENA_CLASSES];                      // Freed blocks of each size
+
+    static int sizeClass(size_t bytes)
+    {
+        if (bytes <= ((size_t)1 << ARENA_MIN_SHIFT))
+            return 0;
+        return 64 - __builtin_clzll(bytes - 1) - ARENA_MIN_SHIFT;
+    }
+
+    /**
+     * @brief Move on to the next chunk, or get a new one if none is left.
+     *        Chunks too small for size are skipped.
+     */
+
+    void nextChunk(size_t size)
+    {
+        if (at != nullptr)
+            current++;
+        else
+            current = 0;
+
+        if (current >= chunks.size()) {
+            size_t bytes = size > ARENA_CHUNK_BYTES ? size : ARENA_CHUNK_BYTES;
+            chunks.push_back(std::make_pair(static_cast<char *>(::operator new(bytes)), bytes));
+            current = chunks.size() - 1;
+        }
+
+        at = chunks[current].first;
+        end = at + chunks[current].second;
+    }
+};
+
+/**
+ * @brief The arena of the innermost ArenaScope on this thread (nullptr =
+ *        none).
+ */
+
+inline thread_local RunArena *currentArena = nullptr;
+
+/**
+ * @brief Routes per-run containers built while it is in scope to arena.
+ */
+
+class ArenaScope {
+public:
+    explicit ArenaScope(RunArena &arena)
+        : outer(currentArena)
+    {
+        currentArena = &arena;
+    }
+
+    ~ArenaScope()
+    {
+        currentArena = outer;
+    }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    RunArena *outer;    // Arena to restore
+};
+
+/**
+ * @brief Standard allocator over the arena current when it was built, or
+ *        the global allocator if there was none.
+ */
+
+template <class T>
+struct RunAllocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    RunArena *arena;    // Where memory comes from (nullptr = global allocator)
+
+    RunAllocator() noexcept : arena(currentArena) {}
+
+    template <class U>
+    RunAllocator(const RunAllocator<U> &other) noexcept : arena(other.arena) {}
+
+    T *allocate(size_t n)
+    {
+        if (arena)
+            return static_cast<T *>(arena->allocate(n * sizeof(T)));
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p,
+                    size_t n)
+    {
+        if (arena)
+            arena->deallocate(p, n * sizeof(T));
+        else
+            std::allocator<T>().deallocate(p, n);
+    }
+
+    template <class U>
+    bool operator==(const RunAllocator<U> &other) const { return arena == other.arena; }
+
+    template <class U>
+    bool operator!=(const RunAllocator<U> &other) const { return arena != other.arena; }
+};
+
+template <class T>
+using RunVector = std::vector<T, RunAllocator<T> >;
+
+template <class Key, class Value>
+using RunHashMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>,
+                                      RunAllocator<std::pair<const Key, Value> > >;
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * Batch runner
+ *
+ * Evaluates many (algorithm, frame count) combinations over one parsed
+ * trace, spreading the jobs across worker threads.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_BATCH_H
+#define PAGER_BATCH_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engines.h"
+#include "remap.h"
+
+/**
+ * @brief One simulation in a batch and its result.
+ */
+
+struct BatchJob {
+    char algo;              // Algorithm code (see algorithmName())
+    int frameCount;         // Number of frames for this run
+    long long pageFaults;   // Filled in by runBatch()
+};
+
+/**
+ * @brief Build the job list: every algorithm crossed with every frame count.
+ *
+ * Jobs are ordered by algorithm (as listed) and then by frame count, which
+ * is also the order results are reported in.
+ */
+
+inline std::vector<BatchJob> makeJobs(const std::string &algos,
+                                      const std::vector<int> &frameCounts)
+{
+    std::vector<BatchJob> jobs;
+
+    for (size_t a = 0; a < algos.size(); a++)
+        for (size_t f = 0; f < frameCounts.size(); f++)
+            jobs.push_back(BatchJob{algos[a], frameCounts[f], 0});
+
+    return jobs;
+}
+
+/**
+ * @brief Run every job over the shared trace.
+ *
+ * Workers pull the next unclaimed job from an atomic counter, so slow jobs
+ * (large OPT runs) do not hold up the rest. The trace is remapped to dense
+ * page numbers once up front and then only read, and each job writes only
+ * its own result, so no locking is needed. OPT's next-use array is built
+ * once and shared by all OPT jobs. Each worker builds its pagers in its
+ * own RunArena (see arena.h), reset after every job.
+ *
+ * @param refs[]      Array of page references
+ * @param refCount    Number of page references
+ * @param jobs        Jobs to run; pageFaults is filled in for each
+ * @param threadCount Number of worker threads (0 = one per core)
+ */
+
+inline void runBatch(const int refs[],
+                     int refCount,
+                     std::vector<BatchJob> &jobs,
+                     int threadCount)
+{
+    // Every job indexes residency directly by dense page number
+    std::vector<int> dense, original;
+    remapTrace(refs, refCount, dense, original);
+
+    RunVector<int> nextUse;
+    for (size_t j = 0; j < jobs.size(); j++) {
+        if (jobs[j].algo == 'O' || jobs[j].algo == 'o') {
+            nextUse = buildNextUse(dense.data(), refCount);
+            break;
+        }
+    }
+
+    if (threadCount <= 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount <= 0)
+        threadCount = 1;
+    if (threadCount > (int)jobs.size())
+        threadCount = jobs.size();
+
+    std::atomic<size_t> nextJob(0);
+
+    auto worker = [&]() {
+        RunArena arena;     // Each job's pager lives here, reset between jobs
+        for (size_t j = nextJob++; j < jobs.size(); j = nextJob++) {
+            {
+                ArenaScope scope(arena);
+                jobs[j].pageFaults = countFaults<DenseIndex>(jobs[j].algo, jobs[j].frameCount,
+                                                             dense.data(), refCount, nextUse.data());
+            }
+            arena.reset();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+        threads.push_back(std::thread(worker));
+    worker();   // The calling thread works too
+
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+}
+
+#endif
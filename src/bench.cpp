@@ -0,0 +1,705 @@
+/**
+ * Page Replacement Benchmark
+ *
+ * Times the replacement engines over synthetic workloads and reports
+ * nanoseconds per reference and references per second as CSV or JSON.
+ * The original linear-scan LRU and OPT loops are kept here as baselines,
+ * so new engines can be compared against them.
+ *
+ * Every call into the global allocator is counted. Timed runs take their
+ * per-run state from a RunArena that is reset between repeats (see
+ * arena.h), and --sweep runs many small scenarios back to back under one
+ * arena to show the allocation count and RSS staying flat; --no-arena
+ * turns the arena off for comparison. With --text each scenario also goes
+ * through the path a multi-line input takes (see runScenarios()): written
+ * out as an input line, parsed, remapped and run with a fault log.
+ *
+ * Build:
+ *   g++ -O2 -pthread src/bench.cpp -o pager-bench
+ *
+ * Run:
+ *   ./pager-bench [--workloads=uniform,zipf,scan,loop,phase]
+ *                 [--engines=fifo,lru,opt,clock,arc,2q,lfu,lru-scan] [--frames=16,256,1024]
+ *                 [--universe=4096] [--length=1000000] [--repeat=3]
+ *                 [--seed=1] [--format=csv|json] [--no-arena]
+ *   ./pager-bench --findpage [--frames=8,16,...,512] [--length=N] [--repeat=N]
+ *   ./pager-bench --sweep=10000 [--workloads=...] [--frames=...] [--length=10000]
+ *                 [--seed=1] [--format=csv|json] [--no-arena] [--text]
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "alloccount.h"
+#include "arena.h"
+#include "engines.h"
+#include "options.h"
+#include "parse.h"
+#include "remap.h"
+#include "trace.h"
+#include "window.h"
+#include "workload.h"
+
+/**
+ * @brief Peak resident set size of the process, in kilobytes.
+ */
+
+long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief The original LRU loop: linear page search and a linear scan of
+ *        lastUsed[] on every eviction.
+ */
+
+long long scanLruFaults(int frameCount,
+                        const int refs[],
+                        int refCount)
+{
+    std::vector<int> frames(frameCount, -1);
+    std::vector<int> lastUsed(frameCount, -1);
+    long long pageFaults = 0;
+
+    for (int t = 0; t < refCount; t++) {
+        int position = findPage(frames.data(), frameCount, refs[t]);
+
+        if (position != -1) {
+            lastUsed[position] = t;
+            continue;
+        }
+
+        pageFaults++;
+
+        int freeIndex = findPage(frames.data(), frameCount, -1);
+        if (freeIndex == -1) {
+            freeIndex = 0;
+            for (int i = 1; i < frameCount; i++)
+                if (lastUsed[i] < lastUsed[freeIndex])
+                    freeIndex = i;
+        }
+
+        frames[freeIndex] = refs[t];
+        lastUsed[freeIndex] = t;
+    }
+
+    return pageFaults;
+}
+
+/**
+ * @brief The original OPT loop: on every eviction, scan forward through the
+ *        trace for each resident page's next use.
+ */
+
+long long scanOptFaults(int frameCount,
+                        const int refs[],
+                        int refCount)
+{
+    std::vector<int> frames(frameCount, -1);
+    long long pageFaults = 0;
+
+    for (int t = 0; t < refCount; t++) {
+        if (findPage(frames.data(), frameCount, refs[t]) != -1)
+            continue;
+
+        pageFaults++;
+
+        int replaceIndex = findPage(frames.data(), frameCount, -1);
+        if (replaceIndex == -1) {
+            int farthestUse = -1;
+            replaceIndex = 0;
+
+            for (int i = 0; i < frameCount; i++) {
+                int nextUse = -1;
+                for (int j = t + 1; j < refCount; j++) {
+                    if (refs[j] == frames[i]) {
+                        nextUse = j;
+                        break;
+                    }
+                }
+
+                if (nextUse == -1) {
+                    replaceIndex = i;
+                    break;
+                }
+                if (nextUse > farthestUse) {
+                    farthestUse = nextUse;
+                    replaceIndex = i;
+                }
+            }
+        }
+
+        frames[replaceIndex] = refs[t];
+    }
+
+    return pageFaults;
+}
+
+long long fifoFaults(int frameCount, const int refs[], int refCount)
+{
+    return countFaults('F', frameCount, refs, refCount);
+}
+
+long long lruFaults(int frameCount, const int refs[], int refCount)
+{
+    return countFaults('L', frameCount, refs, refCount);
+}
+
+long long optFaults(int frameCount, const int refs[], int refCount)
+{
+    return countFaults('O', frameCount, refs, refCount);
+}
+
+long long clockFaults(int frameCount, const int refs[], int refCount)
+{
+    return countFaults('C', frameCount, refs, refCount);
+}
+
+long long arcFaults(int frameCount, const int refs[], int refCount)
+{
+    return countFaults('A', frameCount, refs, refCount);
+}
+
+long long twoQFaults(int frameCount, const int refs[], int refCount)
+{
+    return countFaults('Q', frameCount, refs, refCount);
+}
+
+long long lfuFaults(int frameCount, const int refs[], int refCount)
+{
+    return countFaults('U', frameCount, refs, refCount);
+}
+
+/**
+ * @brief OPT with a look-ahead of 65536 references, as --stream runs it.
+ */
+
+long long windowOptFaults(int frameCount, const int refs[], int refCount)
+{
+    WindowedOptPager pager(frameCount, 65536);
+    for (int t = 0; t < refCount; t++)
+        pager.access(refs[t]);
+    return pager.finish();
+}
+
+/**
+ * @brief Remap the trace to dense pages, then run algo with DenseIndex.
+ *
+ * The remapping pass is part of the timed run.
+ */
+
+template <char algo>
+long long denseFaults(int frameCount, const int refs[], int refCount)
+{
+    RunVector<int> dense, original;
+    remapTrace(refs, refCount, dense, original);
+    return countFaults<DenseIndex>(algo, frameCount, dense.data(), refCount);
+}
+
+/**
+ * @brief A named engine the harness can time.
+ */
+
+struct BenchEngine {
+    const char *name;
+    long long (*run)(int frameCount, const int refs[], int refCount);
+};
+
+const BenchEngine benchEngines[] = {
+    {"fifo", fifoFaults},
+    {"lru", lruFaults},
+    {"opt", optFaults},
+    {"clock", clockFaults},
+    {"arc", arcFaults},
+    {"2q", twoQFaults},
+    {"lfu", lfuFaults},
+    {"opt-window", windowOptFaults},
+    {"fifo-dense", denseFaults<'F'>},
+    {"lru-dense", denseFaults<'L'>},
+    {"opt-dense", denseFaults<'O'>},
+    {"lru-scan", scanLruFaults},
+    {"opt-scan", scanOptFaults},    // Quadratic: only for short traces
+};
+
+/**
+ * @brief One timed (engine, workload, frame count) combination.
+ */
+
+struct BenchResult {
+    std::string engine;
+    std::string workload;
+    int frameCount;
+    long long pageFaults;
+    double nsPerRef;        // Best of the repeats
+    double refsPerSec;
+    long long allocations;  // Global allocator calls during the last repeat
+};
+
+/**
+ * @brief Split a comma-separated list.
+ */
+
+std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream in(list);
+    std::string item;
+
+    while (std::getline(in, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+
+    return items;
+}
+
+/**
+ * @brief Time one engine, keeping the fastest of several runs.
+ *
+ * @param arena Arena for the engine's state, reset after every run
+ *              (nullptr = the global allocator)
+ */
+
+BenchResult timeEngine(const BenchEngine &engine,
+                       const std::string &workload,
+                       int frameCount,
+                       const std::vector<int> &refs,
+                       int repeat,
+                       RunArena *arena)
+{
+    BenchResult result = {engine.name, workload, frameCount, 0, 0, 0, 0};
+    double best = -1;
+
+    for (int r = 0; r < repeat; r++) {
+        long long allocationsBefore = allocationCount;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (arena) {
+            ArenaScope scope(*arena);
+            result.pageFaults = engine.run(frameCount, refs.data(), refs.size());
+        }
+        else
+            result.pageFaults = engine.run(frameCount, refs.data(), refs.size());
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        result.allocations = allocationCount - allocationsBefore;
+        if (arena)
+            arena->reset();
+
+        if (best < 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+
+    result.nsPerRef = refs.empty() ? 0 : best / refs.size();
+    result.refsPerSec = best > 0 ? refs.size() * 1e9 / best : 0;
+    return result;
+}
+
+/**
+ * @brief Print results as CSV (one row per result) or a JSON array.
+ */
+
+void printResults(const std::vector<BenchResult> &results,
+                  int universe,
+                  int length,
+                  bool json)
+{
+    std::cout << std::fixed << std::setprecision(2);
+
+    if (json) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult &r = results[i];
+            std::cout << "  {\"engine\": \"" << r.engine <<
+                "\", \"workload\": \"" << r.workload <<
+                "\", \"universe\": " << universe <<
+                ", \"length\": " << length <<
+                ", \"frames\": " << r.frameCount <<
+                ", \"faults\": " << r.pageFaults <<
+                ", \"ns_per_ref\": " << r.nsPerRef <<
+                ", \"refs_per_sec\": " << r.refsPerSec <<
+                ", \"allocations\": " << r.allocations << "}" <<
+                (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        std::cout << "]\n";
+        return;
+    }
+
+    std::cout << "engine,workload,universe,length,frames,faults,ns_per_ref,refs_per_sec,allocations\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        std::cout << r.engine << "," << r.workload << "," << universe << "," <<
+            length << "," << r.frameCount << "," << r.pageFaults << "," <<
+            r.nsPerRef << "," << r.refsPerSec << "," << r.allocations << "\n";
+    }
+}
+
+/**
+ * @brief Time one findPage kernel over a fixed set of lookups.
+ *
+ * @return Nanoseconds per lookup (best of repeat); checksum receives the
+ *         sum of the returned indices so kernels can be compared
+ */
+
+double timeLookup(int (*kernel)(const int[], int, int),
+                  const std::vector<int> &frames,
+                  const std::vector<int> &pages,
+                  int repeat,
+                  long long &checksum)
+{
+    double best = -1;
+
+    for (int r = 0; r < repeat; r++) {
+        long long sum = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < pages.size(); i++)
+            sum += kernel(frames.data(), frames.size(), pages[i]);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        checksum = sum;
+        if (best < 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+
+    return best / pages.size();
+}
+
+/**
+ * @brief Microbenchmark the findPage kernels for each frame count.
+ *
+ * Half of the lookups hit a random frame and half miss, which is the
+ * mix of a hit check followed by a free-frame search. Exits non-zero if
+ * any kernel disagrees with the scalar loop.
+ */
+
+int benchFindPage(const std::vector<int> &frameCounts,
+                  int lookups,
+                  int repeat,
+                  unsigned long long seed)
+{
+    std::mt19937_64 rng(seed);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "frames,scalar_ns,sse2_ns,avx2_ns,dispatch_ns,speedup\n";
+
+    for (size_t f = 0; f < frameCounts.size(); f++) {
+        int frameCount = frameCounts[f];
+
+        std::vector<int> frames(frameCount);
+        for (int i = 0; i < frameCount; i++)
+            frames[i] = i * 2;      // Even pages are resident, odd ones miss
+
+        std::uniform_int_distribution<int> page(0, frameCount * 2 - 1);
+        std::vector<int> pages(lookups);
+        for (int i = 0; i < lookups; i++)
+            pages[i] = page(rng);
+
+        long long expected, checksum;
+        double scalar = timeLookup(findPageScalar, frames, pages, repeat, expected);
+        double sse2 = -1, avx2 = -1;
+        bool same = true;
+
+#ifdef PAGER_X86
+        sse2 = timeLookup(findPageSse2, frames, pages, repeat, checksum);
+        same = same && checksum == expected;
+        if (cpuHasAvx2()) {
+            avx2 = timeLookup(findPageAvx2, frames, pages, repeat, checksum);
+            same = same && checksum == expected;
+        }
+#endif
+        double dispatch = timeLookup(findPage, frames, pages, repeat, checksum);
+        same = same && checksum == expected;
+
+        if (!same) {
+            std::cerr << "findPage kernels disagree at " << frameCount << " frames\n";
+            return 1;
+        }
+
+        std::cout << frameCount << "," << scalar << "," << sse2 << "," <<
+            avx2 << "," << dispatch << "," << scalar / dispatch << "\n";
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Write a scenario out as an input line ("L,3,1,2,3").
+ *
+ * line is cleared first and keeps its capacity, so a reused line stops
+ * allocating once it has held the longest scenario.
+ */
+
+void formatScenario(char algo,
+                    int frameCount,
+                    const int refs[],
+                    int refCount,
+                    std::string &line)
+{
+    char number[16];
+
+    line.clear();
+    line += algo;
+    std::snprintf(number, sizeof(number), ",%d", frameCount);
+    line += number;
+    for (int t = 0; t < refCount; t++) {
+        std::snprintf(number, sizeof(number), ",%d", refs[t]);
+        line += number;
+    }
+}
+
+/**
+ * @brief Run one input line as runScenarios() does, leaving out only the
+ *        printing: parse it into trace, remap it to dense pages and run
+ *        the algorithm with a fault log.
+ */
+
+long long textScenarioFaults(const std::string &line,
+                             Trace &trace)
+{
+    parseInputLineParallel(line, trace.algo, trace.frameCount, trace.storage, 0);
+    trace.useStorage();
+
+    RunVector<int> dense, original;
+    remapTrace(trace.refs, trace.refCount, dense, original);
+
+    FaultLog log;
+    long long pageFaults = -1;
+    if (trace.algo == 'O') {
+        Pager<OptPolicy, DenseIndex> pager(trace.frameCount, dense.data(), trace.refCount);
+        pageFaults = runPager(pager, dense.data(), trace.refCount, &log);
+    }
+    else
+        visitOnlinePager<DenseIndex>(trace.algo, trace.frameCount, [&](auto &pager) {
+            pageFaults = runPager(pager, dense.data(), trace.refCount, &log);
+        });
+
+    unmapFaultLog(log, original);
+    return pageFaults;
+}
+
+/**
+ * @brief Run many small random scenarios back to back, as a batch sweep
+ *        does, and report how often the global allocator was called and
+ *        how the resident set grew.
+ *
+ * Each scenario runs a random algorithm with a random frame count (up to
+ * maxFrames) over a random slice of at least half of one of the
+ * workloads. With an arena the allocator should be left alone once the
+ * first tenth of the scenarios has warmed it up.
+ *
+ * @param throughText Format and parse each scenario as an input line
+ *                    first (see textScenarioFaults())
+ */
+
+int benchSweep(const std::vector<std::string> &workloadList,
+               int universe,
+               int length,
+               int maxFrames,
+               int scenarios,
+               unsigned long long seed,
+               bool json,
+               bool useArena,
+               bool throughText)
+{
+    std::vector<std::vector<int> > traces(workloadList.size());
+    for (size_t w = 0; w < workloadList.size(); w++) {
+        if (!generateWorkload(workloadList[w], universe, length, seed, traces[w])) {
+            std::cerr << "Unknown workload " << workloadList[w] << "\n";
+            return 1;
+        }
+    }
+
+    const char algos[] = "FLOCAQU";
+    std::mt19937_64 rng(seed);
+    RunArena arena;
+    int warmUp = scenarios / 10 > 0 ? scenarios / 10 : 1;
+    long long references = 0, faults = 0, warmReferences = 0;
+    long long startAllocations = allocationCount, warmAllocations = 0;
+    long rssWarm = 0;
+    std::string line;       // Reused, as runScenarios() reuses its line and trace
+    Trace trace;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < scenarios; i++) {
+        const std::vector<int> &refs = traces[rng() % traces.size()];
+        char algo = algos[rng() % 7];
+        int frameCount = 1 + rng() % maxFrames;
+        int refCount = length - rng() % (length / 2 + 1);
+        int first = rng() % (length - refCount + 1);
+
+        if (throughText)
+            formatScenario(algo, frameCount, refs.data() + first, refCount, line);
+
+        if (useArena) {
+            ArenaScope scope(arena);
+            faults += throughText ? textScenarioFaults(line, trace) :
+                countFaults(algo, frameCount, refs.data() + first, refCount);
+        }
+        else
+            faults += throughText ? textScenarioFaults(line, trace) :
+                countFaults(algo, frameCount, refs.data() + first, refCount);
+        arena.reset();
+        references += refCount;
+
+        if (i + 1 == warmUp) {
+            warmAllocations = allocationCount;
+            warmReferences = references;
+            rssWarm = peakRssKb();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    long long allocations = allocationCount - startAllocations;
+    long long lateAllocations = allocationCount - warmAllocations;
+    long long lateReferences = references - warmReferences;
+    double lateRate = lateReferences ? (double)lateAllocations / lateReferences : 0;
+
+    std::cout << std::fixed << std::setprecision(6);
+    if (json) {
+        std::cout << "{\"arena\": " << (useArena ? "true" : "false") <<
+            ", \"text\": " << (throughText ? "true" : "false") <<
+            ", \"scenarios\": " << scenarios <<
+            ", \"references\": " << references <<
+            ", \"faults\": " << faults <<
+            ", \"allocations\": " << allocations <<
+            ", \"allocations_after_warmup\": " << lateAllocations <<
+            ", \"allocations_per_ref_after_warmup\": " << lateRate <<
+            ", \"arena_kb\": " << arena.reserved() / 1024 <<
+            ", \"rss_warm_kb\": " << rssWarm <<
+            ", \"rss_end_kb\": " << peakRssKb() <<
+            ", \"seconds\": " << elapsed.count() << "}\n";
+        return 0;
+    }
+
+    std::cout << "arena,text,scenarios,references,faults,allocations,allocations_after_warmup,"
+                 "allocations_per_ref_after_warmup,arena_kb,rss_warm_kb,rss_end_kb,seconds\n";
+    std::cout << (useArena ? "yes" : "no") << "," << (throughText ? "yes" : "no") << "," <<
+        scenarios << "," << references << "," << faults << "," << allocations << "," <<
+        lateAllocations << "," << lateRate << "," << arena.reserved() / 1024 << "," <<
+        rssWarm << "," << peakRssKb() << "," << elapsed.count() << "\n";
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string workloads = "uniform,zipf,scan,loop,phase";
+    std::string engines = "fifo,lru,opt,lru-scan";
+    std::string frameSpec = "16,256,1024";
+    int universe = 4096;
+    int length = 1000000;
+    int repeat = 3;
+    unsigned long long seed = 1;
+    bool json = false;
+    bool lookupOnly = false;
+    bool lengthGiven = false;
+    bool useArena = true;
+    bool throughText = false;
+    int sweep = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if (std::string(argv[i]) == "--findpage") {
+            lookupOnly = true;
+            frameSpec = "8,16,32,64,128,256,512";
+        }
+        else if (std::string(argv[i]) == "--no-arena")
+            useArena = false;
+        else if (std::string(argv[i]) == "--text")
+            throughText = true;
+        else if ((value = optionValue(argv[i], "--sweep=")))
+            sweep = std::atoi(value);
+        else if ((value = optionValue(argv[i], "--workloads=")))
+            workloads = value;
+        else if ((value = optionValue(argv[i], "--engines=")))
+            engines = value;
+        else if ((value = optionValue(argv[i], "--frames=")))
+            frameSpec = value;
+        else if ((value = optionValue(argv[i], "--universe=")))
+            universe = std::atoi(value);
+        else if ((value = optionValue(argv[i], "--length="))) {
+            length = std::atoi(value);
+            lengthGiven = true;
+        }
+        else if ((value = optionValue(argv[i], "--repeat=")))
+            repeat = std::atoi(value);
+        else if ((value = optionValue(argv[i], "--seed=")))
+            seed = std::strtoull(value, nullptr, 10);
+        else if ((value = optionValue(argv[i], "--format=")) &&
+                 (std::string(value) == "csv" || std::string(value) == "json"))
+            json = std::string(value) == "json";
+        else {
+            std::cerr << "Unknown option " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    if (sweep > 0 && !lengthGiven)
+        length = 10000;
+
+    std::vector<int> frameCounts;
+    if (!parseFrameList(frameSpec, frameCounts) || universe < 1 || length < 0 || repeat < 1 ||
+        sweep < 0 || (sweep > 0 && length < 1)) {
+        std::cerr << "Bad benchmark parameters.\n";
+        return 1;
+    }
+
+    if (lookupOnly)
+        return benchFindPage(frameCounts, length, repeat, seed);
+
+    std::vector<std::string> workloadList = splitList(workloads);
+    if (sweep > 0) {
+        int maxFrames = 0;
+        for (size_t f = 0; f < frameCounts.size(); f++)
+            if (frameCounts[f] > maxFrames)
+                maxFrames = frameCounts[f];
+        return benchSweep(workloadList, universe, length, maxFrames, sweep, seed, json, useArena,
+                          throughText);
+    }
+
+    // Resolve engine names up front so typos fail before any timing
+    std::vector<const BenchEngine *> selected;
+    std::vector<std::string> engineNames = splitList(engines);
+    for (size_t e = 0; e < engineNames.size(); e++) {
+        const BenchEngine *found = nullptr;
+        for (size_t k = 0; k < sizeof(benchEngines) / sizeof(benchEngines[0]); k++)
+            if (engineNames[e] == benchEngines[k].name)
+                found = &benchEngines[k];
+        if (!found) {
+            std::cerr << "Unknown engine " << engineNames[e] << "\n";
+            return 1;
+        }
+        selected.push_back(found);
+    }
+
+    std::vector<BenchResult> results;
+    std::vector<int> refs;
+    RunArena arena;
+
+    for (size_t w = 0; w < workloadList.size(); w++) {
+        if (!generateWorkload(workloadList[w], universe, length, seed, refs)) {
+            std::cerr << "Unknown workload " << workloadList[w] << "\n";
+            return 1;
+        }
+
+        for (size_t f = 0; f < frameCounts.size(); f++)
+            for (size_t e = 0; e < selected.size(); e++)
+                results.push_back(timeEngine(*selected[e], workloadList[w],
+                                             frameCounts[f], refs, repeat,
+                                             useArena ? &arena : nullptr));
+    }
+
+    printResults(results, universe, length, json);
+    return 0;
+}
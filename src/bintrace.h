@@ -0,0 +1,297 @@
+/**
+ * Binary traces
+ *
+ * A compact binary form of the input format that loads without parsing.
+ *
+ * Layout (all integers little-endian):
+ *   0   char[4]  magic "PGTR"
+ *   4   uint8    version (1)
+ *   5   uint8    encoding: 0 = fixed width, 1 = delta varint blocks
+ *   6   uint8    algorithm code
+ *   7   uint8    page width in bytes for fixed encoding (1, 2 or 4)
+ *   8   uint32   frame count
+ *   12  uint32   references per block (delta varint encoding)
+ *   16  uint64   reference count
+ *   24  uint64   reserved (0)
+ *   32  data
+ *
+ * Fixed encoding stores each page in pageWidth bytes. With a 4-byte width
+ * on a little-endian machine the mapped file is used as the reference
+ * array directly, without copying.
+ *
+ * Delta varint encoding splits the trace into blocks. Each block is a
+ * uint32 byte length followed by its references as zigzag varints of the
+ * difference from the previous reference in the block (the first is taken
+ * against 0), so every block decodes on its own.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_BINTRACE_H
+#define PAGER_BINTRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+enum TraceEncoding {
+    ENCODING_FIXED = 0,
+    ENCODING_VARINT = 1
+};
+
+const size_t TRACE_HEADER_SIZE = 32;
+const std::uint32_t TRACE_BLOCK_REFS = 65536;
+
+/**
+ * @brief Read a little-endian unsigned integer of the given width.
+ */
+
+inline std::uint64_t loadLittle(const unsigned char *p, int width)
+{
+    std::uint64_t value = 0;
+    for (int i = width - 1; i >= 0; i--)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+/**
+ * @brief Append a little-endian unsigned integer of the given width.
+ */
+
+inline void storeLittle(std::vector<unsigned char> &out, std::uint64_t value, int width)
+{
+    for (int i = 0; i < width; i++)
+        out.push_back((value >> (8 * i)) & 0xff);
+}
+
+/**
+ * @brief Check whether a file starts with the binary trace magic.
+ */
+
+inline bool isBinaryTrace(const char *filename)
+{
+    std::FILE *in = std::fopen(filename, "rb");
+    if (!in)
+        return false;
+
+    char magic[4];
+    bool binary = std::fread(magic, 1, 4, in) == 4 && std::memcmp(magic, "PGTR", 4) == 0;
+    std::fclose(in);
+    return binary;
+}
+
+/**
+ * @brief Write a trace in binary form.
+ *
+ * @param filename   Output file
+ * @param algo       Algorithm code to store in the header
+ * @param frameCount Frame count to store in the header
+ * @param refs[]     Page references (non-negative)
+ * @param refCount   Number of page references
+ * @param encoding   ENCODING_FIXED or ENCODING_VARINT
+ *
+ * @return Number of bytes written, or 0 if the file could not be written
+ */
+
+inline size_t writeBinaryTrace(const char *filename,
+                               char algo,
+                               int frameCount,
+                               const int refs[],
+                               int refCount,
+                               TraceEncoding encoding)
+{
+    // Fixed width uses the fewest bytes that hold the largest page
+    int maxPage = 0;
+    for (int t = 0; t < refCount; t++)
+        if (refs[t] > maxPage)
+            maxPage = refs[t];
+    int width = maxPage < 0x100 ? 1 : maxPage < 0x10000 ? 2 : 4;
+
+    std::vector<unsigned char> out;
+    out.insert(out.end(), "PGTR", "PGTR" + 4);
+    out.push_back(1);
+    out.push_back(encoding);
+    out.push_back(algo);
+    out.push_back(encoding == ENCODING_FIXED ? width : 0);
+    storeLittle(out, frameCount, 4);
+    storeLittle(out, TRACE_BLOCK_REFS, 4);
+    storeLittle(out, refCount, 8);
+    storeLittle(out, 0, 8);
+
+    if (encoding == ENCODING_FIXED) {
+        out.reserve(out.size() + (size_t)refCount * width);
+        for (int t = 0; t < refCount; t++)
+            storeLittle(out, refs[t], width);
+    }
+    else {
+        for (int start = 0; start < refCount; start += TRACE_BLOCK_REFS) {
+            int end = refCount - start > (int)TRACE_BLOCK_REFS ? start + TRACE_BLOCK_REFS : refCount;
+
+            size_t lengthAt = out.size();
+            storeLittle(out, 0, 4);     // Patched once the block is written
+
+            std::int64_t previous = 0;
+            for (int t = start; t < end; t++) {
+                std::int64_t delta = (std::int64_t)refs[t] - previous;
+                std::uint64_t zigzag = delta < 0 ? ((std::uint64_t)(-delta) << 1) - 1
+                                                 : (std::uint64_t)delta << 1;
+                while (zigzag >= 0x80) {
+                    out.push_back((zigzag & 0x7f) | 0x80);
+                    zigzag >>= 7;
+                }
+                out.push_back(zigzag);
+                previous = refs[t];
+            }
+
+            std::uint32_t length = out.size() - lengthAt - 4;
+            for (int i = 0; i < 4; i++)
+                out[lengthAt + i] = (length >> (8 * i)) & 0xff;
+        }
+    }
+
+    std::FILE *file = std::fopen(filename, "wb");
+    if (!file)
+        return 0;
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+
+    return ok ? out.size() : 0;
+}
+
+/**
+ * @brief Memory-map a binary trace.
+ *
+ * Fixed 4-byte traces on a little-endian host are used in place; other
+ * encodings are decoded into trace.storage.
+ *
+ * @param filename The binary trace file
+ * @param trace    Receives the header fields and references
+ *
+ * @return nullptr on success, otherwise what is wrong with the file
+ */
+
+inline const char *readBinaryTrace(const char *filename,
+                                   Trace &trace)
+{
+    PAGER_PHASE(PHASE_PARSE);
+
+    int fd = open(filename, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return "Cannot open input file.";
+    }
+
+    size_t size = info.st_size;
+    void *base = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (base == MAP_FAILED || size < TRACE_HEADER_SIZE) {
+        if (base != MAP_FAILED)
+            munmap(base, size);
+        return "Binary trace is truncated.";
+    }
+    madvise(base, size, MADV_SEQUENTIAL);
+    trace.mapping = std::shared_ptr<const void>(base, [size](const void *p) {
+        munmap(const_cast<void *>(p), size);
+    });
+
+    const unsigned char *data = static_cast<const unsigned char *>(base);
+    int encoding = data[5];
+    int width = data[7];
+    std::uint32_t blockRefs = loadLittle(data + 12, 4);
+    std::uint64_t refCount = loadLittle(data + 16, 8);
+
+    bool validHeader = std::memcmp(data, "PGTR", 4) == 0 && data[4] == 1 &&
+        refCount <= 0x7fffffff &&
+        ((encoding == ENCODING_FIXED && (width == 1 || width == 2 || width == 4) &&
+          size - TRACE_HEADER_SIZE >= refCount * width) ||
+         (encoding == ENCODING_VARINT && blockRefs > 0));
+    if (!validHeader)
+        return "Not a valid binary trace.";
+
+    trace.algo = data[6];
+    trace.frameCount = loadLittle(data + 8, 4);
+
+    const unsigned char *p = data + TRACE_HEADER_SIZE;
+    const unsigned char *end = data + size;
+
+    const std::uint32_t one = 1;
+    bool littleEndianHost = *reinterpret_cast<const unsigned char *>(&one) == 1;
+
+    if (encoding == ENCODING_FIXED && width == 4 && littleEndianHost) {
+        // Zero-copy: the header is 32 bytes, so the data stays int-aligned
+        trace.refs = reinterpret_cast<const int *>(p);
+        trace.refCount = refCount;
+        trace.storage.clear();
+        return nullptr;
+    }
+
+    trace.storage.resize(refCount);
+
+    if (encoding == ENCODING_FIXED) {
+        for (std::uint64_t t = 0; t < refCount; t++, p += width)
+            trace.storage[t] = loadLittle(p, width);
+    }
+    else {
+        std::uint64_t t = 0;
+        while (t < refCount) {
+            if (end - p < 4)
+                return "Binary trace is truncated.";
+            const unsigned char *blockEnd = p + 4 + loadLittle(p, 4);
+            p += 4;
+            if (blockEnd > end)
+                return "Binary trace is truncated.";
+
+            std::int64_t previous = 0;
+            std::uint64_t blockStop = t + blockRefs < refCount ? t + blockRefs : refCount;
+            for (; t < blockStop; t++) {
+                std::uint64_t zigzag = 0;
+                int shift = 0;
+                do {
+                    if (p == blockEnd || shift > 63)
+                        return "Binary trace is corrupt.";
+                    zigzag |= (std::uint64_t)(*p & 0x7f) << shift;
+                    shift += 7;
+                } while (*p++ & 0x80);
+
+                std::int64_t delta = (zigzag & 1) ? -(std::int64_t)(zigzag >> 1) - 1
+                                                  : (std::int64_t)(zigzag >> 1);
+                previous += delta;
+                trace.storage[t] = previous;
+            }
+            p = blockEnd;
+        }
+    }
+
+    trace.useStorage();
+    trace.mapping.reset();
+    return nullptr;
+}
+
+/**
+ * @brief readBinaryTrace(), exiting with an error message if the file is
+ *        not a valid binary trace.
+ */
+
+inline void loadBinaryTrace(const char *filename,
+                            Trace &trace)
+{
+    const char *error = readBinaryTrace(filename, trace);
+    if (error) {
+        std::cerr << error << "\n";
+        std::exit(1);
+    }
+}
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * Checkpoints
+ *
+ * A streamed run can save its state every N references and later resume
+ * from it instead of from reference 0. A snapshot is the input position
+ * plus the raw arrays of the pager (frames, and the policy's own state),
+ * copied into one reusable buffer and written with a single fwrite.
+ *
+ * Snapshots are written to "<path>.tmp" and renamed over <path>, so an
+ * interruption mid-write leaves the previous snapshot intact. They are not
+ * fsync'd: they survive the process being killed, not the machine losing
+ * power.
+ *
+ * Only policies with saveState()/loadState() (FIFO and LRU) can be
+ * checkpointed inside a scenario; every scenario also gets a snapshot at
+ * its end, so a resumed run skips the scenarios already finished.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_CHECKPOINT_H
+#define PAGER_CHECKPOINT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const char CHECKPOINT_MAGIC[4] = {'P', 'G', 'C', 'K'};
+const std::uint32_t CHECKPOINT_VERSION = 3;
+
+/**
+ * @brief Appends raw values and arrays to a byte buffer.
+ */
+
+class StateWriter {
+public:
+    void clear() { data.clear(); }
+
+    const std::vector<char> &bytes() const { return data; }
+
+    template <class T>
+    void put(const T &value)
+    {
+        const char *raw = reinterpret_cast<const char *>(&value);
+        data.insert(data.end(), raw, raw + sizeof value);
+    }
+
+    template <class Allocator>
+    void put(const std::vector<int, Allocator> &values)
+    {
+        const char *raw = reinterpret_cast<const char *>(values.data());
+        data.insert(data.end(), raw, raw + values.size() * sizeof(int));
+    }
+
+private:
+    std::vector<char> data;     // Everything put so far
+};
+
+/**
+ * @brief Reads back what a StateWriter wrote, in the same order.
+ *
+ * Reads past the end fail and leave ok() false rather than reading
+ * garbage, so a truncated snapshot is detected.
+ */
+
+class StateReader {
+public:
+    StateReader(const char *data, size_t size)
+        : at(data), end(data + size), good(true) {}
+
+    template <class T>
+    bool get(T &value)
+    {
+        return take(&value, sizeof value);
+    }
+
+    /**
+     * @brief Read into an array whose size is already known.
+     */
+
+    template <class Allocator>
+    bool get(std::vector<int, Allocator> &values)
+    {
+        return take(values.data(), values.size() * sizeof(int));
+    }
+
+    bool ok() const { return good; }
+
+    size_t remaining() const { return end - at; }
+
+private:
+    const char *at;     // Next unread byte
+    const char *end;    // End of the data
+    bool good;          // False once a read has failed
+
+    bool take(void *out, size_t bytes)
+    {
+        if (!good || (size_t)(end - at) < bytes)
+            return good = false;
+        std::memcpy(out, at, bytes);
+        at += bytes;
+        return true;
+    }
+};
+
+/**
+ * @brief Where a streamed run is: which scenario, and how far into it.
+ *
+ * algo is 0 at a scenario boundary, in which case offset is the start of
+ * the next scenario line and there is no pager state.
+ */
+
+struct StreamPosition {
+    char algo;              // Algorithm of the scenario in progress (0 = none)
+    int frameCount;         // Its frame count
+    int scenario;           // 1-based scenario number
+    int line;               // Line of the input the scenario is on
+    long long offset;       // Input byte offset of the next unread character
+    long long refCount;     // References consumed so far in the scenario
+};
+
+/**
+ * @brief Write a position one field at a time, so no padding reaches the
+ *        file and equal positions always give equal bytes.
+ */
+
+inline void putPosition(StateWriter &out,
+                        const StreamPosition &position)
+{
+    out.put(position.algo);
+    out.put(position.frameCount);
+    out.put(position.scenario);
+    out.put(position.line);
+    out.put(position.offset);
+    out.put(position.refCount);
+}
+
+/**
+ * @brief Read a position written by putPosition().
+ */
+
+inline bool getPosition(StateReader &in,
+                        StreamPosition &position)
+{
+    return in.get(position.algo) && in.get(position.frameCount) && in.get(position.scenario) &&
+           in.get(position.line) && in.get(position.offset) && in.get(position.refCount);
+}
+
+/**
+ * @brief Writes snapshots of a streamed run to one file.
+ */
+
+class Checkpoint {
+public:
+    /**
+     * @param path     The snapshot file
+     * @param interval References between snapshots inside a scenario
+     */
+
+    Checkpoint(const char *path, long long interval)
+        : file(path), tmpFile(std::string(path) + ".tmp"), every(interval) {}
+
+    const char *path() const { return file.c_str(); }
+
+    long long interval() const { return every; }
+
+    /**
+     * @brief Save position plus the state of pager.
+     *
+     * @return false if the snapshot could not be written
+     */
+
+    template <class Engine>
+    bool save(const StreamPosition &position,
+              const Engine &pager)
+    {
+        begin(position);
+        pager.saveState(state);
+        return commit();
+    }
+
+    /**
+     * @brief Save a scenario boundary (position.algo must be 0).
+     */
+
+    bool save(const StreamPosition &position)
+    {
+        begin(position);
+        return commit();
+    }
+
+    /**
+     * @brief Remove the snapshot once the run is complete.
+     */
+
+    void finish()
+    {
+        std::remove(file.c_str());
+    }
+
+private:
+    std::string file;       // The snapshot file
+    std::string tmpFile;    // Written first, then renamed to file
+    long long every;        // References between snapshots
+    StateWriter state;      // Reused for every snapshot
+
+    void begin(const StreamPosition &position)
+    {
+        state.clear();
+        state.put(CHECKPOINT_MAGIC);
+        state.put(CHECKPOINT_VERSION);
+        putPosition(state, position);
+    }
+
+    bool commit()
+    {
+        std::FILE *out = std::fopen(tmpFile.c_str(), "wb");
+        if (!out)
+            return false;
+        bool written = std::fwrite(state.bytes().data(), 1, state.bytes().size(), out) ==
+                       state.bytes().size();
+        written = std::fclose(out) == 0 && written;
+        return written && std::rename(tmpFile.c_str(), file.c_str()) == 0;
+    }
+};
+
+/**
+ * @brief Read a snapshot written by Checkpoint.
+ *
+ * @param path     The snapshot file
+ * @param position Receives the saved position
+ * @param state    Receives the pager state that follows it (empty at a
+ *                 scenario boundary), for the pager's loadState()
+ *
+ * @return false if the file is missing or not a snapshot
+ */
+
+inline bool readCheckpoint(const char *path,
+                           StreamPosition &position,
+                           std::vector<char> &state)
+{
+    std::FILE *in = std::fopen(path, "rb");
+    if (!in)
+        return false;
+
+    std::vector<char> data;
+    char chunk[1 << 16];
+    size_t got;
+    while ((got = std::fread(chunk, 1, sizeof chunk, in)) > 0)
+        data.insert(data.end(), chunk, chunk + got);
+    std::fclose(in);
+
+    StateReader reader(data.data(), data.size());
+    char magic[4];
+    std::uint32_t version;
+    if (!reader.get(magic) || std::memcmp(magic, CHECKPOINT_MAGIC, 4) != 0 ||
+        !reader.get(version) || version != CHECKPOINT_VERSION || !getPosition(reader, position))
+        return false;
+
+    state.assign(data.end() - reader.remaining(), data.end());
+    return true;
+}
+
+#endif
@@ -0,0 +1,374 @@
+/**
+ * Cost model
+ *
+ * Fault counts treat every miss alike. With a write flag per reference
+ * (see parseWriteFlags()) a page becomes dirty when written, and evicting
+ * a dirty page costs a write-back on top of the fault that replaced it.
+ * runCosted() charges configurable costs for hits, faults and write-backs
+ * to any pager, giving an estimate of total I/O time.
+ *
+ * Two policies use the costs to choose victims:
+ *
+ *   CFLRU     clean-first LRU: among the window least recently used
+ *             frames, evict the least recent clean page, and a dirty one
+ *             only if all of them are dirty.
+ *   COST-OPT  Belady's rule weighed by cost: a dirty page's distance to
+ *             its next use is divided by how much dearer it is to evict.
+ *             A heuristic, not the cost-optimal schedule.
+ *
+ * Without writes both behave exactly like LRU and OPT.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_COST_H
+#define PAGER_COST_H
+
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "engines.h"
+#include "instrument.h"
+#include "remap.h"
+
+/**
+ * @brief What each event costs, in any one time unit.
+ */
+
+struct CostModel {
+    double hit;         // Reference to a resident page
+    double fault;       // Loading a page (the eviction of a clean page is free)
+    double writeBack;   // Writing a dirty page out when it is evicted
+};
+
+/**
+ * @brief Results of runCosted().
+ */
+
+struct CostResult {
+    long long hits;         // References to resident pages
+    long long faults;       // Page faults
+    long long writeBacks;   // Dirty pages evicted
+    long long dirtyAtEnd;   // Dirty pages still resident after the last reference
+    double cost;            // Total cost of the run (dirty pages left resident are not charged)
+};
+
+/**
+ * @brief CFLRU replacement (Park et al.): LRU that prefers to evict clean
+ *        pages.
+ *
+ * The recency list is split into a working region at the front and a
+ * clean-first region of window frames at the back, which is itself kept
+ * as one list of clean and one of dirty frames. Both stay in recency
+ * order, so the victim is the back of the clean list, or of the dirty
+ * list if there are no clean frames, and every hook is O(1).
+ */
+
+struct CflruPolicy : PolicyBase {
+    enum Region : char { WORKING, CLEAN_TAIL, DIRTY_TAIL };
+
+    SlotList working;               // Most recently used frames, most recent first
+    SlotList cleanTail;             // Clean frames of the clean-first region
+    SlotList dirtyTail;             // Dirty frames of the clean-first region
+    RunVector<char> regionOf;       // Region of each frame
+    RunVector<char> dirty;          // Whether each frame has been written
+    const char *writes;             // Write flag of each reference (nullptr = reads only)
+    int workingLimit;               // Frames in the working region once memory is full
+
+    /**
+     * @param frameCount Number of frames that can be used
+     * @param writes[]   Write flag of each reference, or nullptr
+     * @param window     Frames in the clean-first region (1..frameCount)
+     */
+
+    CflruPolicy(int frameCount, const char writes[], int window)
+        : working(frameCount), cleanTail(frameCount), dirtyTail(frameCount),
+          regionOf(frameCount, WORKING), dirty(frameCount, 0), writes(writes),
+          workingLimit(frameCount - window) {}
+
+    void onHit(int slot, long long t)
+    {
+        if (writes && writes[t])
+            dirty[slot] = 1;
+
+        if (regionOf[slot] == WORKING) {
+            working.moveToFront(slot);
+            return;
+        }
+
+        tailOf(slot).remove(slot);
+        enter(slot);
+    }
+
+    int chooseVictim(int, long long)
+    {
+        SlotList &from = cleanTail.size() > 0 ? cleanTail : dirtyTail;
+        int slot = from.back();
+        from.remove(slot);
+        return slot;
+    }
+
+    void onMiss(int slot, int, long long t)
+    {
+        dirty[slot] = writes && writes[t];
+        enter(slot);
+    }
+
+private:
+    SlotList &tailOf(int slot)
+    {
+        return regionOf[slot] == CLEAN_TAIL ? cleanTail : dirtyTail;
+    }
+
+    /**
+     * @brief Put a frame at the front of the working region, pushing the
+     *        region's oldest frame into the clean-first region if it is
+     *        now too big.
+     */
+
+    void enter(int slot)
+    {
+        working.pushFront(slot);
+        regionOf[slot] = WORKING;
+
+        if (working.size() > workingLimit) {
+            int oldest = working.back();
+            working.remove(oldest);
+            regionOf[oldest] = dirty[oldest] ? DIRTY_TAIL : CLEAN_TAIL;
+            tailOf(oldest).pushFront(oldest);
+        }
+    }
+};
+
+/**
+ * @brief Cost-weighted OPT replacement.
+ *
+ * Evicting a clean page costs a fault when it is next used; evicting a
+ * dirty one also costs a write-back now. The victim is the page with the
+ * most references until its next use per unit of that cost. Clean and
+ * dirty frames sit in separate max-heaps of (next use, -frame), as in
+ * OptPolicy, so only the two tops need comparing: O(log frames) per
+ * reference. Ties go to the clean page.
+ */
+
+struct CostOptPolicy : PolicyBase {
+    typedef std::priority_queue<std::pair<int, int>, RunVector<std::pair<int, int> > > Heap;
+
+    RunVector<int> nextOf;      // Next use of the page in each frame (-1 = empty)
+    RunVector<char> dirty;      // Whether each frame has been written
+    const int *nextUse;         // Next use of each reference in the trace
+    const char *writes;         // Write flag of each reference (nullptr = reads only)
+    double cleanCost;           // Cost of evicting a clean page
+    double dirtyCost;           // Cost of evicting a dirty page
+    Heap clean;                 // Clean frames, may hold stale entries
+    Heap written;               // Dirty frames, may hold stale entries
+
+    /**
+     * @param frameCount Number of frames that can be used
+     * @param nextUse[]  buildNextUse() of the trace
+     * @param writes[]   Write flag of each reference, or nullptr
+     * @param model      The costs to weigh evictions by
+     */
+
+    CostOptPolicy(int frameCount, const int nextUse[], const char writes[], const CostModel &model)
+        : nextOf(frameCount, -1), dirty(frameCount, 0), nextUse(nextUse), writes(writes),
+          cleanCost(model.fault), dirtyCost(model.fault + model.writeBack) {}
+
+    void onHit(int slot, long long t)
+    {
+        if (writes && writes[t])
+            dirty[slot] = 1;
+        setNext(slot, nextUse[t]);
+    }
+
+    int chooseVictim(int, long long t)
+    {
+        prune(clean, 0);
+        prune(written, 1);
+
+        bool fromClean;
+        if (clean.empty() || written.empty())
+            fromClean = !clean.empty();
+        else                        // Compare (gap / cost) without dividing
+            fromClean = (clean.top().first - t) * dirtyCost >=
+                        (written.top().first - t) * cleanCost;
+
+        Heap &from = fromClean ? clean : written;
+        int slot = -from.top().second;
+        from.pop();
+        nextOf[slot] = -1;
+        return slot;
+    }
+
+    void onMiss(int slot, int, long long t)
+    {
+        dirty[slot] = writes && writes[t];
+        setNext(slot, nextUse[t]);
+    }
+
+private:
+    /**
+     * @brief Drop stale entries from the top of heap, which holds frames
+     *        whose dirty bit is isDirty.
+     */
+
+    void prune(Heap &heap, char isDirty)
+    {
+        while (!heap.empty()) {
+            int slot = -heap.top().second;
+            if (nextOf[slot] == heap.top().first && dirty[slot] == isDirty)
+                return;
+            heap.pop();
+        }
+    }
+
+    void setNext(int slot, int next)
+    {
+        nextOf[slot] = next;
+        (dirty[slot] ? written : clean).push(std::make_pair(next, -slot));
+
+        // Rebuild from the live keys when stale entries outnumber the frames
+        if (clean.size() + written.size() > 2 * nextOf.size() + 16) {
+            Heap liveClean, liveWritten;
+            for (size_t i = 0; i < nextOf.size(); i++)
+                if (nextOf[i] != -1)
+                    (dirty[i] ? liveWritten : liveClean).push(std::make_pair(nextOf[i], -(int)i));
+            clean.swap(liveClean);
+            written.swap(liveWritten);
+        }
+    }
+};
+
+/**
+ * @brief Feed a remapped trace through a pager, charging model's costs.
+ *
+ * Dirty bits are tracked per page, so any policy can be costed.
+ *
+ * @param pager    The pager to run (built for the remapped trace)
+ * @param dense[]  The remapped trace (see remapTrace())
+ * @param writes[] Write flag of each reference, or nullptr
+ * @param refCount Number of page references
+ * @param universe Number of distinct pages
+ * @param model    What each event costs
+ *
+ * @return Counts and total cost
+ */
+
+template <class Engine>
+inline CostResult runCosted(Engine &pager,
+                            const int dense[],
+                            const char writes[],
+                            int refCount,
+                            int universe,
+                            const CostModel &model)
+{
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    RunVector<char> dirty(universe, 0);     // Page -> written since it was loaded
+    CostResult result = {0, 0, 0, 0, 0};
+
+    for (int t = 0; t < refCount; t++) {
+        int page = dense[t];
+
+        if (pager.access(page)) {
+            int victim = pager.evictedPage;
+            if (victim != -1 && dirty[victim]) {
+                result.writeBacks++;
+                dirty[victim] = 0;
+            }
+        }
+        if (writes && writes[t])
+            dirty[page] = 1;
+    }
+
+    result.faults = pager.pageFaults;
+    result.hits = refCount - result.faults;
+    for (int page = 0; page < universe; page++)
+        result.dirtyAtEnd += dirty[page];
+    result.cost = result.hits * model.hit + result.faults * model.fault +
+                  result.writeBacks * model.writeBack;
+    return result;
+}
+
+/**
+ * @brief Name of the cost-aware variant of an algorithm.
+ *
+ * @return "CFLRU" for LRU, "COST-OPT" for OPT, or nullptr if the
+ *         algorithm has none
+ */
+
+inline const char *costAwareName(char algo)
+{
+    switch (algo) {
+        case 'L': case 'l': return "CFLRU";
+        case 'O': case 'o': return "COST-OPT";
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Run an algorithm, or its cost-aware variant, under a cost model.
+ *
+ * @param algo        Algorithm code
+ * @param costAware   Run costAwareName(algo) instead of algo itself
+ * @param frameCount  Number of frames that can be used
+ * @param refs[]      Array of page references
+ * @param writes[]    Write flag of each reference, or nullptr
+ * @param refCount    Number of page references
+ * @param model       What each event costs
+ * @param cleanWindow CFLRU: frames in the clean-first region
+ *                    (0 = a quarter of the frames)
+ * @param result      Receives the counts and cost
+ *
+ * @return false for an unknown algorithm, or a cost-aware variant that
+ *         does not exist
+ */
+
+inline bool runCostModel(char algo,
+                         bool costAware,
+                         int frameCount,
+                         const int refs[],
+                         const char writes[],
+                         int refCount,
+                         const CostModel &model,
+                         int cleanWindow,
+                         CostResult &result)
+{
+    if (!algorithmName(algo) || (costAware && !costAwareName(algo)))
+        return false;
+
+    RunVector<int> dense, original;
+    int universe = remapTrace(refs, refCount, dense, original);
+
+    RunVector<int> nextUse;
+    if (algo == 'O' || algo == 'o')
+        nextUse = buildNextUse(dense.data(), refCount);
+
+    if (costAware && (algo == 'L' || algo == 'l')) {
+        if (cleanWindow <= 0)
+            cleanWindow = (frameCount + 3) / 4;
+        if (cleanWindow > frameCount)
+            cleanWindow = frameCount;
+        Pager<CflruPolicy, DenseIndex> pager(frameCount, writes, cleanWindow);
+        result = runCosted(pager, dense.data(), writes, refCount, universe, model);
+    }
+    else if (costAware) {
+        Pager<CostOptPolicy, DenseIndex> pager(frameCount, nextUse.data(), writes, model);
+        result = runCosted(pager, dense.data(), writes, refCount, universe, model);
+    }
+    else if (algo == 'O' || algo == 'o') {
+        Pager<OptPolicy, DenseIndex> pager(frameCount, nextUse.data());
+        result = runCosted(pager, dense.data(), writes, refCount, universe, model);
+    }
+    else {
+        visitOnlinePager<DenseIndex>(algo, frameCount, [&](auto &pager) {
+            result = runCosted(pager, dense.data(), writes, refCount, universe, model);
+        });
+    }
+
+    return true;
+}
+
+#endif
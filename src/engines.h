@@ -0,0 +1,1073 @@
+/**
+ * Replacement engines
+ *
+ * FIFO, LRU and OPT page replacement. Each is a policy for the shared
+ * Pager<> driver, which takes one reference at a time, so FIFO and LRU
+ * can run over a streamed trace as well as over a parsed reference array.
+ * OPT needs the whole trace up front to know the future.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_ENGINES_H
+#define PAGER_ENGINES_H
+
+#include <algorithm>
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pager.h"
+
+/**
+ * @brief One page fault: which frame changed and what it held before.
+ */
+
+struct FaultEvent {
+    int t;          // Index of the faulting reference
+    int slot;       // Frame the page was loaded into
+    int evicted;    // Page that was replaced (-1 if the frame was empty)
+    int loaded;     // Page that was loaded
+};
+
+typedef RunVector<FaultEvent> FaultLog;     // Faults in time order
+
+/**
+ * @brief Frames threaded on a doubly-linked list, most recent at the front.
+ *
+ * Every operation is O(1). A frame must be on at most one list at a time.
+ */
+
+class SlotList {
+public:
+    explicit SlotList(int frameCount)
+        : newer(frameCount, -1), older(frameCount, -1), first(-1), last(-1), count(0) {}
+
+    int front() const { return first; }
+    int back() const { return last; }
+    int size() const { return count; }
+
+    /**
+     * @brief Insert a frame at the front of the list.
+     */
+
+    void pushFront(int slot)
+    {
+        newer[slot] = -1;
+        older[slot] = first;
+        if (first != -1) newer[first] = slot;
+        else last = slot;
+        first = slot;
+        count++;
+    }
+
+    /**
+     * @brief Remove a frame from the list.
+     */
+
+    void remove(int slot)
+    {
+        if (newer[slot] != -1) older[newer[slot]] = older[slot];
+        else first = older[slot];
+
+        if (older[slot] != -1) newer[older[slot]] = newer[slot];
+        else last = newer[slot];
+        count--;
+    }
+
+    /**
+     * @brief Move a frame already on the list to the front.
+     */
+
+    void moveToFront(int slot)
+    {
+        if (slot != first) {
+            remove(slot);
+            pushFront(slot);
+        }
+    }
+
+    template <class Out>
+    void saveState(Out &out) const
+    {
+        out.put(first);
+        out.put(last);
+        out.put(count);
+        out.put(newer);
+        out.put(older);
+    }
+
+    template <class In>
+    bool loadState(In &in)
+    {
+        int size = newer.size();
+        if (!in.get(first) || !in.get(last) || !in.get(count) || !in.get(newer) || !in.get(older) ||
+            first < -1 || first >= size || last < -1 || last >= size || count < 0 || count > size)
+            return false;
+        for (int slot = 0; slot < size; slot++)
+            if (newer[slot] < -1 || newer[slot] >= size || older[slot] < -1 || older[slot] >= size)
+                return false;
+        return true;
+    }
+
+private:
+    RunVector<int> newer;       // Next frame towards the front (-1 = none)
+    RunVector<int> older;       // Next frame towards the back (-1 = none)
+    int first;                  // Front frame (-1 = empty)
+    int last;                   // Back frame (-1 = empty)
+    int count;                  // Number of frames on the list
+};
+
+/**
+ * @brief Recently evicted pages, newest at the front.
+ *
+ * Scan-resistant policies remember pages they no longer hold so they can
+ * tell a returning page from a new one. Membership, insertion and removal
+ * from anywhere in the list are all O(1).
+ */
+
+class GhostList {
+public:
+    GhostList() : first(-1), last(-1) {}
+
+    int size() const { return nodeOf.size(); }
+
+    bool contains(int page) const
+    {
+        return nodeOf.count(page) != 0;
+    }
+
+    /**
+     * @brief Remember a page at the front of the list.
+     */
+
+    void pushFront(int page)
+    {
+        int node;
+        if (spare.empty()) {
+            node = pageAt.size();
+            pageAt.push_back(page);
+            newer.push_back(-1);
+            older.push_back(-1);
+        }
+        else {
+            node = spare.back();
+            spare.pop_back();
+            pageAt[node] = page;
+        }
+
+        newer[node] = -1;
+        older[node] = first;
+        if (first != -1) newer[first] = node;
+        else last = node;
+        first = node;
+        nodeOf[page] = node;
+    }
+
+    /**
+     * @brief Forget a page, wherever it is in the list.
+     */
+
+    void erase(int page)
+    {
+        RunHashMap<int, int>::iterator it = nodeOf.find(page);
+        if (it == nodeOf.end())
+            return;
+
+        int node = it->second;
+        nodeOf.erase(it);
+
+        if (newer[node] != -1) older[newer[node]] = older[node];
+        else first = older[node];
+
+        if (older[node] != -1) newer[older[node]] = newer[node];
+        else last = newer[node];
+
+        spare.push_back(node);
+    }
+
+    /**
+     * @brief Forget the oldest page.
+     */
+
+    void popBack()
+    {
+        erase(pageAt[last]);
+    }
+
+private:
+    RunHashMap<int, int> nodeOf;            // Page -> node holding it
+    RunVector<int> pageAt;                  // Page held by each node
+    RunVector<int> newer;                   // Next node towards the front (-1 = none)
+    RunVector<int> older;                   // Next node towards the back (-1 = none)
+    RunVector<int> spare;                   // Nodes free for reuse
+    int first;                              // Newest node (-1 = empty)
+    int last;                               // Oldest node (-1 = empty)
+};
+
+/**
+ * @brief FIFO replacement: remove the oldest loaded page.
+ *
+ * Frames fill in order, so once memory is full the oldest page is always
+ * in the frame after the one replaced last. Removing a page breaks that
+ * order, so the first onRemove() switches to an explicit queue of frames.
+ */
+
+struct FifoPolicy : PolicyBase {
+    int fifoIndex;      // Points to the next frame to evict (oldest loaded page)
+    int frameCount;     // Number of frames that can be used
+    int filled;         // Frames loaded so far, until the queue takes over
+    bool queued;        // Whether the queue is in use
+    SlotList queue;     // Frames in load order, newest at the front
+
+    explicit FifoPolicy(int frameCount)
+        : fifoIndex(0), frameCount(frameCount), filled(0), queued(false), queue(0) {}
+
+    int chooseVictim(int, long long)
+    {
+        if (queued) {
+            int slot = queue.back();
+            queue.remove(slot);
+            return slot;
+        }
+
+        // Move the FIFO pointer so the next eviction replaces the next oldest frame
+        int slot = fifoIndex;
+        fifoIndex = fifoIndex + 1 == frameCount ? 0 : fifoIndex + 1;
+        return slot;
+    }
+
+    void onMiss(int slot, int, long long)
+    {
+        if (queued)
+            queue.pushFront(slot);
+        else if (filled < frameCount)
+            filled++;
+    }
+
+    void onRemove(int slot)
+    {
+        if (!queued) {
+            // Queue the loaded frames oldest first, starting at the pointer
+            queue = SlotList(frameCount);
+            for (int i = 0; i < filled; i++)
+                queue.pushFront((fifoIndex + i) % frameCount);
+            queued = true;
+        }
+        queue.remove(slot);
+    }
+
+    template <class Out>
+    void saveState(Out &out) const
+    {
+        out.put(fifoIndex);
+        out.put(filled);
+        out.put(queued);
+        if (queued)
+            queue.saveState(out);
+    }
+
+    template <class In>
+    bool loadState(In &in)
+    {
+        if (!in.get(fifoIndex) || !in.get(filled) || !in.get(queued) ||
+            fifoIndex < 0 || fifoIndex >= frameCount || filled < 0 || filled > frameCount)
+            return false;
+        queue = SlotList(queued ? frameCount : 0);
+        return !queued || queue.loadState(in);
+    }
+};
+
+/**
+ * @brief LRU replacement: remove the least recently used page.
+ *
+ * The frames are kept on a recency list, so hits and evictions are O(1)
+ * no matter how many frames there are.
+ */
+
+struct LruPolicy : PolicyBase {
+    SlotList recency;   // Most recently used frame at the front
+
+    explicit LruPolicy(int frameCount)
+        : recency(frameCount) {}
+
+    void onHit(int slot, long long)
+    {
+        // Page is already in memory, move it to the front of the list
+        recency.moveToFront(slot);
+    }
+
+    int chooseVictim(int, long long)
+    {
+        int slot = recency.back();
+        recency.remove(slot);
+        return slot;
+    }
+
+    void onMiss(int slot, int, long long)
+    {
+        recency.pushFront(slot);
+    }
+
+    void onRemove(int slot)
+    {
+        recency.remove(slot);
+    }
+
+    template <class Out>
+    void saveState(Out &out) const
+    {
+        recency.saveState(out);
+    }
+
+    template <class In>
+    bool loadState(In &in)
+    {
+        return recency.loadState(in);
+    }
+};
+
+/**
+ * @brief Largest page number looked up through a flat table rather than a
+ *        hash map, when the trace is long enough to pay for the table.
+ */
+
+const int FLAT_PAGE_LIMIT = 1 << 24;
+
+/**
+ * @brief Find, for every reference, where the same page is used next.
+ *
+ * One backward pass over the trace.
+ *
+ * @param refs[]   Array of page references from the input
+ * @param refCount Number of page references in the input
+ *
+ * @return nextUse[t], the index of the next reference to refs[t], or
+ *         refCount if the page is never used again
+ */
+
+inline RunVector<int> buildNextUse(const int refs[],
+                                     int refCount)
+{
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    RunVector<int> nextUse(refCount);
+
+    int maxPage = 0;
+    bool negative = false;
+    for (int t = 0; t < refCount; t++) {
+        if (refs[t] > maxPage)
+            maxPage = refs[t];
+        negative |= refs[t] < 0;
+    }
+
+    if (!negative && maxPage < FLAT_PAGE_LIMIT && maxPage / 4 <= refCount) {
+        // Small page numbers (such as a remapped trace): index a flat table
+        RunVector<int> seenAt(maxPage + 1, refCount);
+        for (int t = refCount - 1; t >= 0; t--) {
+            nextUse[t] = seenAt[refs[t]];
+            seenAt[refs[t]] = t;
+        }
+        return nextUse;
+    }
+
+    RunHashMap<int, int> seenAt;            // Page -> earliest index seen so far
+
+    for (int t = refCount - 1; t >= 0; t--) {
+        RunHashMap<int, int>::iterator it = seenAt.find(refs[t]);
+        if (it == seenAt.end()) {
+            nextUse[t] = refCount;
+            seenAt[refs[t]] = t;
+        }
+        else {
+            nextUse[t] = it->second;
+            it->second = t;
+        }
+    }
+
+    return nextUse;
+}
+
+
+/**
+ * @brief OPT (Belady) replacement: remove the page whose next use is
+ *        farthest in the future.
+ *
+ * Next uses come from buildNextUse() and the resident frames sit in a
+ * max-heap keyed by next use, so each reference costs O(log frames). When
+ * several pages are never used again the lowest-numbered frame is evicted,
+ * as the original forward scan did.
+ */
+
+struct OptPolicy : PolicyBase {
+    typedef std::priority_queue<std::pair<int, int>, RunVector<std::pair<int, int> > > Heap;
+
+    RunVector<int> nextOf;                  // Next use of the page in each frame (-1 = empty)
+    RunVector<int> ownNextUse;              // Next-use array built by this policy, if any
+    const int *nextUse;                     // Next use of each reference in the trace
+    Heap byNextUse;                         // (next use, -frame), may hold stale entries
+
+    /**
+     * @param frameCount Number of frames that can be used
+     * @param refs[]     The whole trace the pager will be fed, in order
+     * @param refCount   Number of page references in the trace
+     */
+
+    OptPolicy(int frameCount, const int refs[], int refCount)
+        : nextOf(frameCount, -1), ownNextUse(buildNextUse(refs, refCount)),
+          nextUse(ownNextUse.data()) {}
+
+    /**
+     * @param frameCount Number of frames that can be used
+     * @param nextUse[]  buildNextUse() of the trace, shared with other pagers
+     */
+
+    OptPolicy(int frameCount, const int nextUse[])
+        : nextOf(frameCount, -1), nextUse(nextUse) {}
+
+    void onHit(int slot, long long t)
+    {
+        // Re-key the frame with the page's following use
+        setNext(slot, nextUse[t]);
+    }
+
+    int chooseVictim(int, long long)
+    {
+        // Heap entries whose key no longer matches their frame are stale
+        while (nextOf[-byNextUse.top().second] != byNextUse.top().first)
+            byNextUse.pop();
+        int slot = -byNextUse.top().second;
+        byNextUse.pop();
+        return slot;
+    }
+
+    void onMiss(int slot, int, long long t)
+    {
+        setNext(slot, nextUse[t]);
+    }
+
+    void onRemove(int slot)
+    {
+        // Its heap entries are now stale
+        nextOf[slot] = -1;
+    }
+
+private:
+    /**
+     * @brief Record a frame's next use and push it on the heap.
+     */
+
+    void setNext(int slot, int next)
+    {
+        nextOf[slot] = next;
+        byNextUse.push(std::make_pair(next, -slot));
+
+        // Stale entries pile up on hits; rebuild from the live keys when
+        // they outnumber the frames
+        if (byNextUse.size() > 2 * nextOf.size() + 16) {
+            Heap live;
+            for (size_t i = 0; i < nextOf.size(); i++)
+                if (nextOf[i] != -1)
+                    live.push(std::make_pair(nextOf[i], -(int)i));
+            byNextUse.swap(live);
+        }
+    }
+};
+
+/**
+ * @brief CLOCK (second chance) replacement.
+ *
+ * A hand sweeps the frames in order. A frame whose reference bit is set
+ * has the bit cleared and is passed over; the first frame with a clear bit
+ * is replaced. Every bit the hand clears was set by a reference, so the
+ * sweep is O(1) amortized.
+ */
+
+struct ClockPolicy : PolicyBase {
+    RunVector<char> referenced;     // Reference bit of each frame
+    int hand;                       // Next frame the hand will look at
+
+    explicit ClockPolicy(int frameCount)
+        : referenced(frameCount, 0), hand(0) {}
+
+    void onHit(int slot, long long)
+    {
+        referenced[slot] = 1;
+    }
+
+    int chooseVictim(int, long long)
+    {
+        while (referenced[hand]) {
+            referenced[hand] = 0;
+            hand = hand + 1 == (int)referenced.size() ? 0 : hand + 1;
+        }
+
+        int slot = hand;
+        hand = hand + 1 == (int)referenced.size() ? 0 : hand + 1;
+        return slot;
+    }
+
+    void onMiss(int slot, int, long long)
+    {
+        referenced[slot] = 1;
+    }
+
+    void onRemove(int slot)
+    {
+        referenced[slot] = 0;
+    }
+};
+
+/**
+ * @brief ARC (Adaptive Replacement Cache, Megiddo and Modha) replacement.
+ *
+ * Resident pages are split between T1 (seen once recently) and T2 (seen at
+ * least twice), each an LRU list. Ghost lists B1 and B2 remember pages
+ * recently evicted from T1 and T2; a miss that hits a ghost list moves the
+ * target size p of T1 towards the list that would have kept the page.
+ */
+
+struct ArcPolicy : PolicyBase {
+    SlotList t1;                    // Resident, referenced once since loaded
+    SlotList t2;                    // Resident, referenced more than once
+    GhostList b1;                   // Evicted from t1
+    GhostList b2;                   // Evicted from t2
+    RunVector<char> inT2;           // Whether each frame is on t2
+    RunVector<int> pageIn;          // Page held by each frame
+    int capacity;                   // Number of frames (c in the paper)
+    int target;                     // Target size of t1 (p in the paper)
+
+    explicit ArcPolicy(int frameCount)
+        : t1(frameCount), t2(frameCount), inT2(frameCount, 0),
+          pageIn(frameCount, -1), capacity(frameCount), target(0) {}
+
+    void onHit(int slot, long long)
+    {
+        // Case I: a hit in either list makes the page frequent
+        if (inT2[slot]) {
+            t2.moveToFront(slot);
+        }
+        else {
+            t1.remove(slot);
+            t2.pushFront(slot);
+            inT2[slot] = 1;
+        }
+    }
+
+    int chooseVictim(int page, long long)
+    {
+        if (b1.contains(page)) {
+            // Case II: recency would have kept it, grow t1
+            target = std::min(capacity, target + std::max(b2.size() / b1.size(), 1));
+            return replace(false);
+        }
+
+        if (b2.contains(page)) {
+            // Case III: frequency would have kept it, shrink t1
+            target = std::max(0, target - std::max(b1.size() / b2.size(), 1));
+            return replace(true);
+        }
+
+        // Case IV: a new page; keep the directory within 2c pages
+        if (t1.size() + b1.size() == capacity) {
+            if (t1.size() < capacity) {
+                b1.popBack();
+                return replace(false);
+            }
+            int slot = t1.back();
+            t1.remove(slot);
+            return slot;
+        }
+
+        if (t1.size() + t2.size() + b1.size() + b2.size() == 2 * capacity)
+            b2.popBack();
+        return replace(false);
+    }
+
+    void onMiss(int slot, int page, long long)
+    {
+        pageIn[slot] = page;
+
+        if (b1.contains(page) || b2.contains(page)) {
+            b1.erase(page);
+            b2.erase(page);
+            t2.pushFront(slot);
+            inT2[slot] = 1;
+        }
+        else {
+            // Case IV without REPLACE, when the frame was freed by
+            // onRemove(): make room in the directory. After a REPLACE
+            // there already is room, so this never fires then
+            if (t1.size() + b1.size() >= capacity)
+                b1.popBack();
+            else if (t1.size() + t2.size() + b1.size() + b2.size() >= 2 * capacity)
+                b2.popBack();
+
+            t1.pushFront(slot);
+            inT2[slot] = 0;
+        }
+    }
+
+    void onRemove(int slot)
+    {
+        // Taken, not evicted, so no ghost entry
+        if (inT2[slot]) t2.remove(slot);
+        else t1.remove(slot);
+    }
+
+private:
+    /**
+     * @brief REPLACE from the paper: evict from t1 or t2 into its ghost list.
+     *
+     * @param inB2 Whether the incoming page is on b2
+     */
+
+    int replace(bool inB2)
+    {
+        if (t1.size() > 0 && (t1.size() > target || (inB2 && t1.size() == target))) {
+            int slot = t1.back();
+            t1.remove(slot);
+            b1.pushFront(pageIn[slot]);
+            return slot;
+        }
+
+        int slot = t2.back();
+        t2.remove(slot);
+        b2.pushFront(pageIn[slot]);
+        return slot;
+    }
+};
+
+/**
+ * @brief 2Q replacement (Johnson and Shasha, full version).
+ *
+ * New pages enter A1in, a FIFO holding about a quarter of the frames.
+ * Pages pushed out of A1in are remembered on the ghost list A1out (half
+ * the frame count); only a page that comes back while on A1out is loaded
+ * into Am, the LRU list of pages known to be reused. A one-time scan
+ * therefore cycles through A1in without disturbing Am.
+ */
+
+struct TwoQPolicy : PolicyBase {
+    SlotList a1in;                  // Resident, first-time pages in FIFO order
+    SlotList am;                    // Resident, reused pages in LRU order
+    GhostList a1out;                // Recently pushed out of a1in
+    RunVector<char> inAm;           // Whether each frame is on am
+    RunVector<int> pageIn;          // Page held by each frame
+    int inLimit;                    // Kin: a1in may grow past this only while am is empty
+    int outLimit;                   // Kout: most pages a1out remembers
+    bool returning;                 // The page being loaded was on a1out before its victim was chosen
+
+    explicit TwoQPolicy(int frameCount)
+        : a1in(frameCount), am(frameCount), inAm(frameCount, 0),
+          pageIn(frameCount, -1),
+          inLimit(std::max(1, frameCount / 4)),
+          outLimit(std::max(1, frameCount / 2)), returning(false) {}
+
+    void onHit(int slot, long long)
+    {
+        // Hits on a1in leave it alone, so a burst of references to a new
+        // page does not make it look reused
+        if (inAm[slot])
+            am.moveToFront(slot);
+    }
+
+    int chooseVictim(int page, long long)
+    {
+        // Trimming a1out below may drop the incoming page itself, so
+        // decide now whether it is coming back
+        returning = a1out.contains(page);
+
+        if (a1in.size() > inLimit || am.size() == 0) {
+            int slot = a1in.back();
+            a1in.remove(slot);
+            a1out.pushFront(pageIn[slot]);
+            if (a1out.size() > outLimit)
+                a1out.popBack();
+            return slot;
+        }
+
+        int slot = am.back();
+        am.remove(slot);
+        return slot;
+    }
+
+    void onMiss(int slot, int page, long long)
+    {
+        pageIn[slot] = page;
+
+        if (returning || a1out.contains(page)) {
+            a1out.erase(page);
+            am.pushFront(slot);
+            inAm[slot] = 1;
+        }
+        else {
+            a1in.pushFront(slot);
+            inAm[slot] = 0;
+        }
+        returning = false;
+    }
+
+    void onRemove(int slot)
+    {
+        if (inAm[slot]) am.remove(slot);
+        else a1in.remove(slot);
+    }
+};
+
+/**
+ * @brief LFU replacement: remove the least frequently used page.
+ *
+ * Uses the O(1) scheme of Shah, Mitra and Matani: frames with the same
+ * reference count share a bucket, and the buckets form a list in count
+ * order, so a hit moves a frame to the neighbouring bucket and the victim
+ * is always in the first one. Counts start at 1 when a page is loaded and
+ * are forgotten on eviction. Ties go to the least recently used page.
+ */
+
+struct LfuPolicy : PolicyBase {
+    RunVector<int> bucketOf;            // Bucket holding each frame
+    RunVector<int> newer;               // Next more recent frame in the same bucket (-1 = none)
+    RunVector<int> older;               // Next less recent frame in the same bucket (-1 = none)
+    RunVector<long long> countOf;       // Reference count of each bucket
+    RunVector<int> newest;              // Most recent frame in each bucket
+    RunVector<int> oldest;              // Least recent frame in each bucket
+    RunVector<int> higher;              // Bucket with the next larger count (-1 = none)
+    RunVector<int> lower;               // Bucket with the next smaller count (-1 = none)
+    RunVector<int> spare;               // Buckets free for reuse
+    int lowest;                         // Bucket with the smallest count (-1 = none)
+
+    // At most one bucket per frame, plus one while a hit moves a frame
+    explicit LfuPolicy(int frameCount)
+        : bucketOf(frameCount, -1), newer(frameCount, -1), older(frameCount, -1),
+          countOf(frameCount + 1), newest(frameCount + 1), oldest(frameCount + 1),
+          higher(frameCount + 1), lower(frameCount + 1), lowest(-1)
+    {
+        for (int b = frameCount; b >= 0; b--)
+            spare.push_back(b);
+    }
+
+    void onHit(int slot, long long)
+    {
+        int from = bucketOf[slot];
+        int to = higher[from];
+        if (to == -1 || countOf[to] != countOf[from] + 1)
+            to = newBucket(countOf[from] + 1, from);
+
+        take(slot);
+        put(slot, to);
+    }
+
+    int chooseVictim(int, long long)
+    {
+        int slot = oldest[lowest];
+        take(slot);
+        return slot;
+    }
+
+    void onMiss(int slot, int, long long)
+    {
+        int to = lowest;
+        if (to == -1 || countOf[to] != 1)
+            to = newBucket(1, -1);
+        put(slot, to);
+    }
+
+    void onRemove(int slot)
+    {
+        take(slot);
+    }
+
+private:
+    /**
+     * @brief Start an empty bucket for count, right after bucket after
+     *        (-1 = at the start of the list).
+     */
+
+    int newBucket(long long count, int after)
+    {
+        int b = spare.back();
+        spare.pop_back();
+
+        countOf[b] = count;
+        newest[b] = oldest[b] = -1;
+        lower[b] = after;
+        higher[b] = after == -1 ? lowest : higher[after];
+        if (higher[b] != -1) lower[higher[b]] = b;
+        if (after != -1) higher[after] = b;
+        else lowest = b;
+
+        return b;
+    }
+
+    /**
+     * @brief Add a frame to a bucket as its most recent member.
+     */
+
+    void put(int slot, int b)
+    {
+        bucketOf[slot] = b;
+        newer[slot] = -1;
+        older[slot] = newest[b];
+        if (newest[b] != -1) newer[newest[b]] = slot;
+        else oldest[b] = slot;
+        newest[b] = slot;
+    }
+
+    /**
+     * @brief Remove a frame from its bucket, dropping the bucket if empty.
+     */
+
+    void take(int slot)
+    {
+        int b = bucketOf[slot];
+
+        if (newer[slot] != -1) older[newer[slot]] = older[slot];
+        else newest[b] = older[slot];
+
+        if (older[slot] != -1) newer[older[slot]] = newer[slot];
+        else oldest[b] = newer[slot];
+
+        if (newest[b] == -1) {
+            if (lower[b] != -1) higher[lower[b]] = higher[b];
+            else lowest = higher[b];
+            if (higher[b] != -1) lower[higher[b]] = lower[b];
+            spare.push_back(b);
+        }
+    }
+};
+
+typedef Pager<FifoPolicy> FifoPager;
+typedef Pager<LruPolicy> LruPager;
+typedef Pager<OptPolicy> OptPager;
+typedef Pager<ClockPolicy> ClockPager;
+typedef Pager<ArcPolicy> ArcPager;
+typedef Pager<TwoQPolicy> TwoQPager;
+typedef Pager<LfuPolicy> LfuPager;
+
+/**
+ * @brief Feed a whole trace through a pager.
+ *
+ * @param pager    The pager to run
+ * @param refs[]   Array of page references from the input
+ * @param refCount Number of page references in the input
+ * @param log      Receives one event per fault (nullptr to skip)
+ *
+ * @return Number of page faults that occurred
+ */
+
+template <class Engine>
+inline long long runPager(Engine &pager,
+                          const int refs[],
+                          int refCount,
+                          FaultLog *log)
+{
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    // Walk through each page request one at a time
+    for (int t = 0; t < refCount; t++) {
+        bool fault = pager.access(refs[t]);
+
+        // Only record an event when the memory actually changed,
+        // on page faults
+        if (fault && log)
+            log->push_back(FaultEvent{t, pager.faultSlot, pager.evictedPage, refs[t]});
+    }
+
+    return pager.pageFaults;
+}
+
+/**
+ * @brief Runs the FIFO algorithm that removes oldest loaded page
+ *        when new page fault occurs and no free frame is available
+ *
+ * @param frameCount Number of frames that can be used
+ * @param refs[]     Array of page references from the input
+ * @param refCount   Number of page references in the input
+ * @param log        Receives one event per fault (nullptr to skip)
+ *
+ * @return Number of page faults that occurred while running FIFO
+ */
+
+inline int FIFO(int frameCount,
+                const int refs[],
+                int refCount,
+                FaultLog *log)
+{
+    std::cout << "Running FIFO" << "\n";
+
+    FifoPager pager(frameCount);
+    return runPager(pager, refs, refCount, log);
+}
+
+/**
+ * @brief Runs the OPT algorithm, which removes the page whose next use
+ *        is farthest in the future when a new page fault occurs
+ *
+ * @param frameCount Number of frames that can be used
+ * @param refs[]     Array of page references from the input
+ * @param refCount   Number of page references in the input
+ * @param log        Receives one event per fault (nullptr to skip)
+ *
+ * @return Number of page faults that occurred while running OPT
+ */
+
+inline int OPT(int frameCount,
+               const int refs[],
+               int refCount,
+               FaultLog *log)
+{
+    std::cout << "Running OPT" << "\n";
+
+    OptPager pager(frameCount, refs, refCount);
+    return runPager(pager, refs, refCount, log);
+}
+
+/**
+ * @brief Runs the LRU algorithm, which will remove the least recently used page from memory when a new page fault occurs
+ */
+
+inline int LRU(int frameCount,
+               const int refs[],
+               int refCount,
+               FaultLog *log)
+{
+    std::cout << "Running LRU" << "\n";
+
+    LruPager pager(frameCount);
+    return runPager(pager, refs, refCount, log);
+}
+
+/**
+ * @brief Full name of an algorithm code.
+ *
+ * @return "FIFO", "LRU", "OPT", "CLOCK", "ARC", "2Q" or "LFU", or nullptr
+ *         for an unknown code
+ */
+
+inline const char *algorithmName(char algo)
+{
+    switch (algo) {
+        case 'F': case 'f': return "FIFO";
+        case 'L': case 'l': return "LRU";
+        case 'O': case 'o': return "OPT";
+        case 'C': case 'c': return "CLOCK";
+        case 'A': case 'a': return "ARC";
+        case 'Q': case 'q': return "2Q";
+        case 'U': case 'u': return "LFU";
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Build the pager for an algorithm that needs no look-ahead and
+ *        hand it to visit.
+ *
+ * Every algorithm except OPT can be run this way, including over a
+ * streamed trace.
+ *
+ * @tparam Index     Residency index for the pager (see Pager)
+ *
+ * @param algo       Algorithm code
+ * @param frameCount Number of frames that can be used
+ * @param visit      Called once with the pager, e.g. a generic lambda
+ *
+ * @return false if algo is OPT or unknown (visit is not called)
+ */
+
+template <class Index = FrameIndex, class Visit>
+inline bool visitOnlinePager(char algo,
+                             int frameCount,
+                             Visit visit)
+{
+    switch (algo) {
+        case 'F': case 'f': { Pager<FifoPolicy, Index> pager(frameCount); visit(pager); return true; }
+        case 'L': case 'l': { Pager<LruPolicy, Index> pager(frameCount); visit(pager); return true; }
+        case 'C': case 'c': { Pager<ClockPolicy, Index> pager(frameCount); visit(pager); return true; }
+        case 'A': case 'a': { Pager<ArcPolicy, Index> pager(frameCount); visit(pager); return true; }
+        case 'Q': case 'q': { Pager<TwoQPolicy, Index> pager(frameCount); visit(pager); return true; }
+        case 'U': case 'u': { Pager<LfuPolicy, Index> pager(frameCount); visit(pager); return true; }
+    }
+    return false;
+}
+
+/**
+ * @brief Runs any algorithm by its code, printing "Running <name>" first
+ *
+ * @tparam Index     Residency index for the pager (see Pager)
+ *
+ * @param algo       Algorithm code
+ * @param frameCount Number of frames that can be used
+ * @param refs[]     Array of page references from the input
+ * @param refCount   Number of page references in the input
+ * @param log        Receives one event per fault (nullptr to skip)
+ *
+ * @return Number of page faults, or -1 for an unknown algorithm
+ */
+
+template <class Index = FrameIndex>
+inline long long runAlgorithm(char algo,
+                              int frameCount,
+                              const int refs[],
+                              int refCount,
+                              FaultLog *log)
+{
+    const char *name = algorithmName(algo);
+    if (!name)
+        return -1;
+
+    std::cout << "Running " << name << "\n";
+
+    if (algo == 'O' || algo == 'o') {
+        Pager<OptPolicy, Index> pager(frameCount, refs, refCount);
+        return runPager(pager, refs, refCount, log);
+    }
+
+    long long pageFaults = -1;
+    visitOnlinePager<Index>(algo, frameCount, [&](auto &pager) {
+        pageFaults = runPager(pager, refs, refCount, log);
+    });
+    return pageFaults;
+}
+
+/**
+ * @brief Count page faults for one algorithm without printing anything.
+ *
+ * @tparam Index     Residency index for the pager (see Pager)
+ *
+ * @param algo       Algorithm code
+ * @param frameCount Number of frames that can be used
+ * @param refs[]     Array of page references
+ * @param refCount   Number of page references
+ * @param nextUse[]  Precomputed buildNextUse() for OPT, or nullptr
+ *
+ * @return Number of page faults, or -1 for an unknown algorithm
+ */
+
+template <class Index = FrameIndex>
+inline long long countFaults(char algo,
+                             int frameCount,
+                             const int refs[],
+                             int refCount,
+                             const int nextUse[] = nullptr)
+{
+    if (algo == 'O' || algo == 'o') {
+        if (nextUse) {
+            Pager<OptPolicy, Index> pager(frameCount, nextUse);
+            return runPager(pager, refs, refCount, nullptr);
+        }
+        Pager<OptPolicy, Index> pager(frameCount, refs, refCount);
+        return runPager(pager, refs, refCount, nullptr);
+    }
+
+    long long pageFaults = -1;
+    visitOnlinePager<Index>(algo, frameCount, [&](auto &pager) {
+        pageFaults = runPager(pager, refs, refCount, nullptr);
+    });
+    return pageFaults;
+}
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * Page lookup
+ *
+ * findPage() is the inner loop of every engine that searches its frames.
+ * On x86 each loop step compares 8 (SSE2) or 16 (AVX2) frames, two vector
+ * compares of 4 or 8, picking the widest kernel the CPU supports at run
+ * time; elsewhere, and for very small frame counts, it is a plain scalar
+ * loop. Every kernel returns the
+ * lowest matching index, so results are identical.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_FINDPAGE_H
+#define PAGER_FINDPAGE_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PAGER_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Find a page in the view
+ *
+ * @param frames the frames to search
+ * @param frameCount the number of frames that can be used
+ * @param page the page to find
+ */
+
+inline int findPageScalar(const int frames[],           // The frames
+                          int frameCount,               // The number of frames that can be used
+                          int page)                     // The page to find
+{
+    for (int i = 0;                                     // Start of for loop
+        i < frameCount;                                 // While i is less than frameCount
+        i++) {                                          // Increment the index
+
+        if (frames[i] == page)                          // If the page is found
+            return i;                                   // Return index
+    }                                                   // End for loop
+
+    return -1;                                          // Return -1 if page not found
+}                                                       // End of function findPageScalar
+
+#ifdef PAGER_X86
+
+/**
+ * @brief findPageScalar() comparing 8 frames per step with SSE2.
+ */
+
+__attribute__((target("sse2")))
+inline int findPageSse2(const int frames[],
+                        int frameCount,
+                        int page)
+{
+    const __m128i needle = _mm_set1_epi32(page);
+    int i = 0;
+
+    for (; i + 8 <= frameCount; i += 8) {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(frames + i)), needle);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(frames + i + 4)), needle);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(a)) |
+                   (_mm_movemask_ps(_mm_castsi128_ps(b)) << 4);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    for (; i < frameCount; i++)
+        if (frames[i] == page)
+            return i;
+
+    return -1;
+}
+
+/**
+ * @brief findPageScalar() comparing 16 frames per step with AVX2.
+ */
+
+__attribute__((target("avx2")))
+inline int findPageAvx2(const int frames[],
+                        int frameCount,
+                        int page)
+{
+    const __m256i needle = _mm256_set1_epi32(page);
+    int i = 0;
+
+    for (; i + 16 <= frameCount; i += 16) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(frames + i)), needle);
+        __m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(frames + i + 8)), needle);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(a)) |
+                   (_mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+
+    if (i + 8 <= frameCount) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(frames + i)), needle);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(a));
+        if (mask)
+            return i + __builtin_ctz(mask);
+        i += 8;
+    }
+
+    for (; i < frameCount; i++)
+        if (frames[i] == page)
+            return i;
+
+    return -1;
+}
+
+/**
+ * @brief Whether this CPU can run the AVX2 kernel (checked once).
+ */
+
+inline bool cpuHasAvx2()
+{
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    return hasAvx2;
+}
+
+#endif
+
+/**
+ * @brief Find a page in the view, using the fastest kernel available.
+ *
+ * @param frames the frames to search
+ * @param frameCount the number of frames that can be used
+ * @param page the page to find
+ *
+ * @return Index of the first frame holding page, or -1
+ */
+
+inline int findPage(const int frames[],
+                    int frameCount,
+                    int page)
+{
+#ifdef PAGER_X86
+    if (frameCount >= 16)
+        return cpuHasAvx2() ? findPageAvx2(frames, frameCount, page)
+                            : findPageSse2(frames, frameCount, page);
+    if (frameCount >= 8)
+        return findPageSse2(frames, frameCount, page);
+#endif
+    return findPageScalar(frames, frameCount, page);
+}
+
+#endif
@@ -0,0 +1,340 @@
+/**
+ * Memory hierarchies
+ *
+ * Chains two or more pagers into tiers, fastest first, each with its own
+ * algorithm and frame count. A reference is looked up tier by tier; the
+ * first tier holding the page serves it, and a page found in no tier comes
+ * from memory. Two ways of sharing pages between tiers are simulated:
+ *
+ *   inclusive  every tier holds a copy of the pages above it. A miss loads
+ *              the page into each tier it missed, and a page evicted from
+ *              a lower tier is also removed from the tiers above it.
+ *   exclusive  a page is in at most one tier. A page served by a lower
+ *              tier moves to the top; each tier's victim is demoted into
+ *              the tier below, and the last tier's victim is dropped.
+ *
+ * Lower tiers only see the references that reach them, as in a real
+ * cache. OPT tiers are the exception in what they know: they rank pages by
+ * their next use in the whole trace, not in the stream reaching the tier.
+ *
+ * Every tier uses a DenseIndex over the remapped trace, so each reference
+ * costs O(1) per tier for the lookups, plus the policy's own cost.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_HIERARCHY_H
+#define PAGER_HIERARCHY_H
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "engines.h"
+#include "instrument.h"
+#include "remap.h"
+
+/**
+ * @brief One tier as given on the command line.
+ */
+
+struct TierSpec {
+    char algo;          // Algorithm code
+    int frameCount;     // Frames in the tier
+    double latency;     // Cost of looking a page up in the tier
+};
+
+/**
+ * @brief Parse a tier list such as "L4@1,L64@10,O1024".
+ *
+ * Each tier is an algorithm code, a frame count and optionally "@" and a
+ * latency. A tier without a latency gets ten times the one above it,
+ * starting at 1.
+ *
+ * @param spec  The list, fastest tier first
+ * @param tiers Receives the tiers
+ *
+ * @return false if the list is malformed, names an unknown algorithm or
+ *         has a tier with no frames
+ */
+
+inline bool parseTierList(const std::string &spec,
+                          std::vector<TierSpec> &tiers)
+{
+    tiers.clear();
+
+    size_t i = 0;
+    while (i < spec.size()) {
+        TierSpec tier = {spec[i++], 0, tiers.empty() ? 1 : tiers.back().latency * 10};
+        if (!algorithmName(tier.algo))
+            return false;
+
+        size_t start = i;
+        while (i < spec.size() && spec[i] >= '0' && spec[i] <= '9')
+            tier.frameCount = tier.frameCount * 10 + (spec[i++] - '0');
+        if (i == start || tier.frameCount < 1)
+            return false;
+
+        if (i < spec.size() && spec[i] == '@') {
+            size_t end = spec.find(',', ++i);
+            if (end == std::string::npos)
+                end = spec.size();
+            std::string text = spec.substr(i, end - i);
+            char *rest;
+            tier.latency = std::strtod(text.c_str(), &rest);
+            if (text.empty() || *rest || !(tier.latency >= 0))
+                return false;
+            i = end;
+        }
+
+        tiers.push_back(tier);
+        if (i < spec.size() && spec[i++] != ',')
+            return false;
+    }
+
+    return !tiers.empty();
+}
+
+/**
+ * @brief A pager of any policy, seen through the few operations a
+ *        hierarchy needs. Tiers are chosen at run time, so this is the one
+ *        place a reference goes through a virtual call.
+ */
+
+class Tier {
+public:
+    virtual ~Tier() {}
+
+    virtual bool contains(int page) const = 0;
+
+    /**
+     * @brief Pager::access(page, t).
+     */
+
+    virtual bool access(int page, long long t) = 0;
+
+    /**
+     * @brief Page replaced by the latest fault (-1 = none).
+     */
+
+    virtual int evicted() const = 0;
+
+    virtual void remove(int page) = 0;
+};
+
+template <class Policy>
+class PolicyTier : public Tier {
+public:
+    template <class... Args>
+    explicit PolicyTier(int frameCount, Args &&... args)
+        : pager(frameCount, std::forward<Args>(args)...) {}
+
+    bool contains(int page) const { return pager.contains(page); }
+
+    bool access(int page, long long t) { return pager.access(page, t); }
+
+    int evicted() const { return pager.evictedPage; }
+
+    void remove(int page) { pager.remove(page); }
+
+private:
+    Pager<Policy, DenseIndex> pager;
+};
+
+/**
+ * @brief Build a tier for an algorithm code.
+ *
+ * @param nextUse[] buildNextUse() of the remapped trace, for OPT
+ *
+ * @return The tier, or nullptr for an unknown code
+ */
+
+inline std::unique_ptr<Tier> makeTier(char algo,
+                                      int frameCount,
+                                      const int nextUse[])
+{
+    switch (algo) {
+        case 'F': case 'f': return std::unique_ptr<Tier>(new PolicyTier<FifoPolicy>(frameCount));
+        case 'L': case 'l': return std::unique_ptr<Tier>(new PolicyTier<LruPolicy>(frameCount));
+        case 'O': case 'o': return std::unique_ptr<Tier>(new PolicyTier<OptPolicy>(frameCount, nextUse));
+        case 'C': case 'c': return std::unique_ptr<Tier>(new PolicyTier<ClockPolicy>(frameCount));
+        case 'A': case 'a': return std::unique_ptr<Tier>(new PolicyTier<ArcPolicy>(frameCount));
+        case 'Q': case 'q': return std::unique_ptr<Tier>(new PolicyTier<TwoQPolicy>(frameCount));
+        case 'U': case 'u': return std::unique_ptr<Tier>(new PolicyTier<LfuPolicy>(frameCount));
+    }
+    return nullptr;
+}
+
+/**
+ * @brief What one tier saw.
+ */
+
+struct TierStats {
+    long long hits;     // References this tier served
+    long long faults;   // References that reached this tier and missed
+};
+
+/**
+ * @brief Results of runHierarchy().
+ */
+
+struct HierarchyResult {
+    std::vector<TierStats> tiers;   // Fastest tier first
+    long long memoryAccesses;       // References no tier held
+    double averageLatency;          // Mean cost of a reference
+};
+
+/**
+ * @brief Tiers of pagers fed one reference at a time.
+ */
+
+class Hierarchy {
+public:
+    std::vector<TierStats> stats;   // Per tier, fastest first
+
+    /**
+     * @param specs     The tiers, fastest first
+     * @param exclusive Exclusive rather than inclusive tiers
+     * @param universe  Number of distinct (remapped) pages
+     * @param nextUse[] buildNextUse() of the remapped trace, for OPT tiers
+     */
+
+    Hierarchy(const std::vector<TierSpec> &specs,
+              bool exclusive,
+              int universe,
+              const int nextUse[])
+        : stats(specs.size(), TierStats{0, 0}), exclusive(exclusive),
+          lastRef(exclusive ? universe : 0, 0)
+    {
+        for (size_t i = 0; i < specs.size(); i++)
+            tiers.push_back(makeTier(specs[i].algo, specs[i].frameCount, nextUse));
+    }
+
+    /**
+     * @brief Reference page, which is reference t of the trace.
+     */
+
+    void access(int page, int t)
+    {
+        int count = tiers.size();
+
+        int level = 0;      // First tier holding the page (count = none)
+        while (level < count && !tiers[level]->contains(page))
+            stats[level++].faults++;
+        if (level < count)
+            stats[level].hits++;
+
+        if (exclusive)
+            moveToTop(page, t, level);
+        else
+            fillAbove(page, t, level);
+    }
+
+private:
+    std::vector<std::unique_ptr<Tier> > tiers;  // Fastest first
+    bool exclusive;                             // Exclusive rather than inclusive
+    RunVector<int> lastRef;                     // Exclusive: page -> its latest reference
+
+    /**
+     * @brief Inclusive: touch the page where it was found, then load it into
+     *        each tier above, bottom up, removing every page a tier evicts
+     *        from the tiers above that one.
+     */
+
+    void fillAbove(int page, int t, int level)
+    {
+        if (level < (int)tiers.size())
+            tiers[level]->access(page, t);
+
+        for (int i = level - 1; i >= 0; i--) {
+            tiers[i]->access(page, t);
+
+            int victim = tiers[i]->evicted();
+            if (victim != -1)
+                for (int j = 0; j < i; j++)
+                    tiers[j]->remove(victim);
+        }
+    }
+
+    /**
+     * @brief Exclusive: take the page out of the tier it was found in and
+     *        load it into the top tier, demoting each victim one tier down.
+     *
+     * The tier the page left has a free frame, so the demotions stop there.
+     */
+
+    void moveToTop(int page, int t, int level)
+    {
+        lastRef[page] = t;
+
+        if (level == 0) {
+            tiers[0]->access(page, t);
+            return;
+        }
+        if (level < (int)tiers.size())
+            tiers[level]->remove(page);
+
+        int moving = page;
+        long long when = t;     // A demoted page is keyed by its own latest reference
+        for (size_t i = 0; i < tiers.size() && moving != -1; i++) {
+            tiers[i]->access(moving, when);
+            moving = tiers[i]->evicted();
+            if (moving != -1)
+                when = lastRef[moving];
+        }
+    }
+};
+
+/**
+ * @brief Run a trace through a hierarchy.
+ *
+ * The average latency charges every reference the latency of each tier it
+ * was looked up in, plus memoryLatency if no tier held the page.
+ *
+ * @param refs[]        Array of page references
+ * @param refCount      Number of page references
+ * @param specs         The tiers, fastest first (see parseTierList())
+ * @param exclusive     Exclusive rather than inclusive tiers
+ * @param memoryLatency Cost of fetching a page no tier holds
+ *
+ * @return Per-tier and overall results
+ */
+
+inline HierarchyResult runHierarchy(const int refs[],
+                                    int refCount,
+                                    const std::vector<TierSpec> &specs,
+                                    bool exclusive,
+                                    double memoryLatency)
+{
+    RunVector<int> dense, original;
+    int universe = remapTrace(refs, refCount, dense, original);
+
+    RunVector<int> nextUse;
+    for (size_t i = 0; i < specs.size(); i++)
+        if (specs[i].algo == 'O' || specs[i].algo == 'o') {
+            nextUse = buildNextUse(dense.data(), refCount);
+            break;
+        }
+
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    Hierarchy hierarchy(specs, exclusive, universe, nextUse.data());
+    for (int t = 0; t < refCount; t++)
+        hierarchy.access(dense[t], t);
+
+    HierarchyResult result;
+    result.tiers = hierarchy.stats;
+    result.memoryAccesses = result.tiers.back().faults;
+
+    double total = result.memoryAccesses * memoryLatency;
+    for (size_t i = 0; i < specs.size(); i++)
+        total += (result.tiers[i].hits + result.tiers[i].faults) * specs[i].latency;
+    result.averageLatency = refCount ? total / refCount : 0;
+
+    return result;
+}
+
+#endif
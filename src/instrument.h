@@ -0,0 +1,182 @@
+/**
+ * Instrumentation
+ *
+ * Opt-in counters and phase timers, enabled by building with
+ * -DPAGER_INSTRUMENT. Without it every macro below expands to nothing, so
+ * the normal build carries no trace of them.
+ *
+ *   PAGER_PHASE(phase)     time the rest of the enclosing scope as phase
+ *   PAGER_COUNT(name, n)   add n to counter name
+ *   PAGER_PROBE(length)    record one residency search of length probes
+ *   PAGER_REPORT()         print the report to stderr when the scope ends
+ *
+ * The build also counts calls into the global allocator (see
+ * alloccount.h).
+ *
+ * Time is charged to the innermost running phase only, so nested phases
+ * are not counted twice. Counters and times are kept per thread and
+ * summed when a thread exits, so batch workers do not contend; times from
+ * several workers therefore add up to CPU time, not wall time.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_INSTRUMENT_H
+#define PAGER_INSTRUMENT_H
+
+#ifdef PAGER_INSTRUMENT
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+#include <sys/resource.h>
+
+#include "alloccount.h"
+
+enum Phase { PHASE_NONE = -1, PHASE_PARSE, PHASE_SIMULATE, PHASE_OUTPUT, PHASE_COUNT };
+
+/**
+ * @brief Everything one thread has measured.
+ */
+
+struct InstrumentCounters {
+    double seconds[PHASE_COUNT];    // Time spent in each phase
+    long long lookups;              // Residency lookups (one per reference)
+    long long hits;                 // Lookups that found the page resident
+    long long evictions;            // Pages replaced to make room
+    long long probes;               // Entries examined by all lookups
+    long long maxProbe;             // Entries examined by the longest lookup
+
+    void add(const InstrumentCounters &other)
+    {
+        for (int p = 0; p < PHASE_COUNT; p++)
+            seconds[p] += other.seconds[p];
+        lookups += other.lookups;
+        hits += other.hits;
+        evictions += other.evictions;
+        probes += other.probes;
+        if (other.maxProbe > maxProbe)
+            maxProbe = other.maxProbe;
+    }
+};
+
+inline std::mutex instrumentMutex;                  // Guards instrumentTotals
+inline InstrumentCounters instrumentTotals = {};   // Counters of threads that have exited
+
+/**
+ * @brief A thread's counters, plus which phase its clock is running for.
+ */
+
+struct ThreadInstrument : InstrumentCounters {
+    Phase phase;                                        // Innermost running phase
+    std::chrono::steady_clock::time_point mark;         // When phase was last charged
+
+    ThreadInstrument() : InstrumentCounters(), phase(PHASE_NONE) {}
+
+    ~ThreadInstrument()
+    {
+        std::lock_guard<std::mutex> lock(instrumentMutex);
+        instrumentTotals.add(*this);
+    }
+
+    /**
+     * @brief Charge the time since the last mark to the running phase and
+     *        switch to next.
+     */
+
+    void switchTo(Phase next)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (phase != PHASE_NONE)
+            seconds[phase] += std::chrono::duration<double>(now - mark).count();
+        phase = next;
+        mark = now;
+    }
+};
+
+inline thread_local ThreadInstrument threadInstrument;
+
+/**
+ * @brief Runs a phase's clock for as long as it is in scope.
+ */
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase)
+        : outer(threadInstrument.phase)
+    {
+        threadInstrument.switchTo(phase);
+    }
+
+    ~PhaseTimer()
+    {
+        threadInstrument.switchTo(outer);
+    }
+
+private:
+    Phase outer;    // Phase to resume when this one ends
+};
+
+inline void recordProbe(long long length)
+{
+    threadInstrument.probes += length;
+    if (length > threadInstrument.maxProbe)
+        threadInstrument.maxProbe = length;
+}
+
+/**
+ * @brief Prints the report as one JSON object on stderr when destroyed.
+ */
+
+class InstrumentReport {
+public:
+    InstrumentReport() : start(std::chrono::steady_clock::now()) {}
+
+    ~InstrumentReport()
+    {
+        double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        InstrumentCounters sum;
+        {
+            std::lock_guard<std::mutex> lock(instrumentMutex);
+            sum = instrumentTotals;
+        }
+        sum.add(threadInstrument);
+
+        std::fflush(stdout);                // Keep the report after the normal output
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);     // ru_maxrss is in kilobytes on Linux
+
+        std::fprintf(stderr,
+                     "{\"parse_seconds\":%.6f,\"simulate_seconds\":%.6f,\"output_seconds\":%.6f,"
+                     "\"total_seconds\":%.6f,\"lookups\":%lld,\"hits\":%lld,\"evictions\":%lld,"
+                     "\"probes\":%lld,\"mean_probe\":%.3f,\"max_probe\":%lld,\"allocations\":%lld,"
+                     "\"peak_rss_kb\":%ld}\n",
+                     sum.seconds[PHASE_PARSE], sum.seconds[PHASE_SIMULATE], sum.seconds[PHASE_OUTPUT],
+                     total, sum.lookups, sum.hits, sum.evictions, sum.probes,
+                     sum.lookups ? (double)sum.probes / sum.lookups : 0.0, sum.maxProbe,
+                     allocationCount.load(), (long)usage.ru_maxrss);
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;    // When main() started
+};
+
+#define PAGER_PHASE(phase) PhaseTimer phaseTimer_(phase)
+#define PAGER_COUNT(name, n) (threadInstrument.name += (n))
+#define PAGER_PROBE(length) recordProbe(length)
+#define PAGER_REPORT() InstrumentReport instrumentReport_
+
+#else
+
+#define PAGER_PHASE(phase) ((void)0)
+#define PAGER_COUNT(name, n) ((void)0)
+#define PAGER_PROBE(length) ((void)0)
+#define PAGER_REPORT() ((void)0)
+
+#endif
+
+#endif
@@ -1,8 +1,8 @@
 /**
  * Cache Replacement Simulator
  *
- * Simulates three classical page-replacement algorithms:
- * FIFO, LRU, and OPT 
+ * Simulates page-replacement algorithms:
+ * FIFO (F), LRU (L), OPT (O), CLOCK (C), ARC (A), 2Q (Q) and LFU (U)
  *
  * Input file format:
  *   <AlgorithmCode>,<FrameCount>,<ReferenceString>
@@ -10,20 +10,68 @@
  * Example:
  *   L,3,7,0,1,2,0,3,0,4
  *
+ * A page number followed by 'w' is a write (e.g. 0w); only --cost uses it.
+ *
  * Build:
- *   g++ src/main.cpp -o cacher
+ *   g++ -O2 -pthread src/main.cpp -o cacher
  *
  * Run:
  *   ./cacher <input_file>
+ *   ./cacher --stream [--window=65536] [--checkpoint=<file> [--checkpoint-every=N] [--resume]]
+ *            <input_file>
+ *   ./cacher --summary [--format=text|csv|json] <input_file>
+ *   ./cacher --curve <input_file>
+ *   ./cacher --shards [--rate=0.01] [--max-samples=8192] [--verify] <input_file>
+ *   ./cacher --analyze <input_file>
+ *   ./cacher --hierarchy=L4,L64[@latency,...] [--exclusive] [--memory-latency=X] <input_file>
+ *   ./cacher --cost [--hit-cost=1] [--fault-cost=100] [--writeback-cost=100]
+ *            [--clean-window=N] <input_file>
+ *   ./cacher --working-set=TAU[,TAU...] [--pff=LOWER,UPPER] [--interval=N] <input_file>
+ *   ./cacher --pff=LOWER,UPPER [--interval=N] <input_file>
+ *   ./cacher --serve=<socket> [--threads=N]
+ *   ./cacher --batch [--policies=FLO] [--frames=1-64] [--threads=N] <input_file>
+ *   ./cacher --convert=<binary_file> [--encoding=fixed|varint] <input_file>
+ *
+ * Any mode except --stream also accepts a binary trace written by --convert;
+ * --stream rejects one with an error.
+ * --analyze also accepts a raw trace: page numbers only, with no algorithm
+ * code or frame count, spread over any number of lines. --hierarchy ignores
+ * the algorithm code and frame count of each scenario and uses its tiers;
+ * --working-set and --pff ignore them too and size memory as they go.
+ *
+ * Build with -DPAGER_INSTRUMENT to get a timing and counter report on
+ * stderr (see instrument.h).
  *
  * @author Connor Parr
  * @author Seth Garner
  */
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <string>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
+#include "trace.h"
+#include "engines.h"
+#include "mrc.h"
+#include "shards.h"
+#include "analyze.h"
+#include "window.h"
+#include "hierarchy.h"
+#include "cost.h"
+#include "variable.h"
+#include "serve.h"
+#include "batch.h"
+#include "remap.h"
+#include "options.h"
+#include "parse.h"
+#include "bintrace.h"
+#include "checkpoint.h"
+#include "output.h"
+
 /**
  * @brief Read a single line from the
  * 
@@ -47,132 +95,31 @@ std::string readLineFromFile(const char *filename) {    // Function header
 }
 
 /**
- * @brief Parse the input line and store the values in the given variables.
- * 
- * @param line The input line to parse.
- * @param algo The selected algorithm.
- * @param frameCount The number of frames in the cache.
- * @param refs An array to store the reference values.
- * @param refCount The number of references in the input line.
+ * @brief Load a trace file, text or binary
+ *
+ * @param filename The name of the file to read from
+ * @param trace Receives the algorithm, frame count and references
  */
 
-void parseInputLine(const std::string &line,
-                    char &algo,
-                    int &frameCount,
-                    int refs[],
-                    int &refCount)
+void loadTrace(const char *filename,                    // Function header
+               Trace &trace)                            // The trace to fill
 {
-    // Reset output variables before parsing begins.
-    algo = 0;
-    frameCount = 0;
-    refCount = 0;
-
-    int i = 0;
-    int n = line.size();
-
-    // Skip leading whitespace before reading the algorithm code.
-    while (i < n && (line[i] == ' ' || line[i] == '\t'))
-        i++;
-
-    // First non-space character is the algorithm identifier (F, O, or L).
-    if (i < n)
-        algo = line[i++];
-    else
-        return;   // Empty or malformed line.
-
-    // Move forward to the comma after the algorithm character.
-    while (i < n && line[i] != ',')
-        i++;
-    if (i < n) i++;   // Skip comma
-
-    // Parse the frame count (may contain multiple digits).
-    // Convert characters to an integer until hitting a non-digit.
-    while (i < n && line[i] >= '0' && line[i] <= '9') {
-        frameCount = frameCount * 10 + (line[i] - '0');
-        i++;
-    }
-
-    // Skip the comma separating frame count from the reference string.
-    if (i < n && line[i] == ',')
-        i++;
-
-    // Parse the rest of the line as the page-reference sequence.
-    // Skip commas/whitespace, then read each multi-digit number into refs[].
-    while (i < n) {
-
-        // Skip separators between numbers.
-        while (i < n &&
-              (line[i] == ',' || line[i] == ' ' || line[i] == '\t'))
-            i++;
-
-        if (i >= n) break;
+    if (isBinaryTrace(filename)) {                      // Binary traces are mapped, not parsed
+        loadBinaryTrace(filename, trace);               // Map (or decode) the references
+        return;                                         // Nothing left to do
+    }                                                   // End if statement
 
-        int val = 0;
-        bool hasDigit = false;
+    std::string line = readLineFromFile(filename);      // Read the text input line
 
-        // Convert continuous digits into an integer value.
-        while (i < n && line[i] >= '0' && line[i] <= '9') {
-            val = val * 10 + (line[i] - '0');
-            hasDigit = true;
-            i++;
-        }
+    parseInputLineParallel(line,                        // Parse the input line
+                           trace.algo,                  // Algorithm to be used
+                           trace.frameCount,            // Frame count that can be used
+                           trace.storage,               // Reference array
+                           0);                          // One thread per core for long lines
 
-        // Store parsed page reference in the refs array.
-        if (hasDigit)
-            refs[refCount++] = val;
-    }
+    trace.useStorage();                                 // Point the trace at the parsed references
 }
 
-
-/**
- * @brief Wipe the view table
- * 
- * @param table the view table
- * @param frameCount the number frames that can be used
- * @param refCount the number of references in the input line
- */
-
-void wipeTable(int table[][1000],                       // The view table
-               int &frameCount,                         // The number of frames that can be used
-               int &refCount)                           // The number of references in the input line
-{
-    for (int i = 0;                                     // Start of for loop
-         i < frameCount;                                // While i is less than frameCount
-         i++) {                                         // Increment the index
-
-        for (int j = 0;                                 // Start of for loop
-             j < refCount;                              // While j is less than refCount
-             j++) {                                     // Increment the index
-
-            table[i][j] = -1;                           // Set table[i][j] to -1
-
-        }                                               // End nested for loop
-    }                                                   // End for loop
-}                                                       // End of function wipeTable
-
-/**
- * @brief Find a page in the view
- * 
- * @param frames the frames to search
- * @param frameCount the number of frames that can be used
- * @param page the page to find
- */
-
-int findPage(int frames[],                              // The frames
-             int frameCount,                            // The number of frames that can be used
-             int page)                                  // The page to find
-{
-    for (int i = 0;                                     // Start of for loop
-        i < frameCount;                                 // While i is less than frameCount
-        i++) {                                          // Increment the index
-
-        if (frames[i] == page)                          // If the page is found
-            return i;                                   // Return index
-    }                                                   // End for loop
-
-    return -1;                                          // Return -1 if page not found
-}                                                       // End of function findPage
-
 /**
  * @brief Tester function for testing the program functions
  */
@@ -185,17 +132,18 @@ void testers()
     std::cout << "Input Line: " <<                      // Print the input line
         testLine << "\n";                               // Print the string from the file
 
-    int frameCount, refCount;                           // The number of frames that can be used and the reference count
+    int frameCount;                                     // The number of frames that can be used
     char algo;                                          // The algorithm to use
-    int refs[100];                                      // The reference string
+    std::vector<int> refs;                              // The reference string
 
-    int displayTable[50][1000];                         // Test display table
+    FaultLog faultLog;                                  // Test fault log
 
     parseInputLine(testLine,                            // Testing the parseInputLine function
                    algo,                                // Algorithm to use
                    frameCount,                          // Number of frames that can be used
-                   refs,                                // References from input file
-                   refCount);                           // Number of references from input file
+                   refs);                               // References from input file
+
+    int refCount = refs.size();                         // Number of references from input file
 
     std::cout << "Algorithm: " <<                       // Display algorithm line
         algo << "\n";                                   // The algorithm used
@@ -211,21 +159,22 @@ void testers()
 
     std::cout << "\n";                                  // Insert next line
 
-    wipeTable(displayTable,                             // Wipe the displayTable
-              frameCount,                               // Number of frames that can be used
-              refCount);                                // Number of references from input file
+    int pageFaults = FIFO(frameCount,                   // Testing the FIFO function
+                          refs.data(),                  // References from input file
+                          refCount,                     // Number of references from input file
+                          &faultLog);                   // Fault log to fill
 
-    for (int i = 0;                                     // Start for loop
-         i < frameCount;                                // While index is less than the number of frames that can be used
-         i++) {                                         // Increment the index
+    std::cout << "Page Faults: " <<                     // Display the fault count
+        pageFaults << "\n";                             // Should match the number of log entries
 
-        for (int j = 0;                                 // Start for loop 
-             j < refCount;                              // While index is less than the number of references from input file
-             j++) {                                     // Increment the index
+    for (size_t i = 0;                                  // Start for loop
+         i < faultLog.size();                           // Every logged fault
+         i++) {                                         // Increment the index
 
-            std::cout << displayTable[i][j] << " ";     // Display the table results
-        }                                               // End for loop
-        std::cout << "\n";                              // Insert next line
+        std::cout << faultLog[i].t << " " <<            // Time of the fault
+            faultLog[i].slot << " " <<                  // Frame that changed
+            faultLog[i].evicted << " " <<               // Page replaced
+            faultLog[i].loaded << "\n";                 // Page loaded
     }                                                   // End for loop
     
     std::cout << "\n";                                  // Insert next line
@@ -233,394 +182,1262 @@ void testers()
 }                                                       // End testers function
 
 /**
- * @brief Runs the FIFO algorithm that removes oldest loaded page
- *        when new page fault occurs and no free frame is available
+ * @brief Prints the table to stdout
  *
- * @param frameCount Number of frames that can be used
- * @param refs[]     Array of page references from the input
- * @param refCount   Number of page references in the input
- * @param table[][]  Table used to record the frame contents over time
+ * The frames x references grid is rebuilt row by row from the fault log,
+ * so nothing the size of the grid is ever stored.
  *
- * @return Number of page faults that occurred while running FIFO
+ * @param refs[] Array of references from input file
+ * @param refCount Number of references in input file
+ * @param frameCount Number of frames allowed to be used per
+ * @param log Fault events recorded by the algorithm
+ * @param pageFaults Number of page faults that occurred
  */
 
-int FIFO(int frameCount,
-         int refs[],
-         int refCount,
-         int table[][1000])
+void printTable(const int refs[],
+                int refCount,
+                int frameCount,
+                const FaultLog &log,
+                int pageFaults)
 {
-    std::cout << "Running FIFO" << std::endl;
+    PAGER_PHASE(PHASE_OUTPUT);                          // Instrumented builds time the printing
 
-    int frames[50];     // The memory frames currently holding pages
+    int cellWidth = 2;                                  // Widest cell: page digits and a space
+    for (int t = 0;                                     // Start for loop
+         t < refCount;                                  // Every reference
+         t++) {                                         // Increment the index by one
 
-    // Initialize all frames as empty (-1 means no page loaded yet)
-    for (int i = 0; i < frameCount; i++)
-        frames[i] = -1;
+        if (decimalWidth(refs[t]) + 1 > cellWidth)      // Wider than any cell so far
+            cellWidth = decimalWidth(refs[t]) + 1;      // Remember the new width
+    }                                                   // End for loop
 
-    int pageFaults = 0;     // Count how many misses occur
-    int fifoIndex = 0;      // Points to the next frame to evict (oldest loaded page)
+    size_t rowBytes = (size_t)refCount * cellWidth + 1; // Most bytes any row can take
+    OutputBuffer out(rowBytes > 65536 ? rowBytes : 65536);
 
-    // Walk through each page request one at a time
-    for (int t = 0; t < refCount; t++)
-    {
-        int page = refs[t];
+    out.reserve(rowBytes);                              // Room for the reference row
+    for (int t = 0;                                     // Start for loop
+         t < refCount;                                  // While the index is less than the number of references in the input file
+         t++) {                                         // Increment the index by one
 
-        // Check whether the page is already in memory
-        int position = findPage(frames, frameCount, page);
+        out.putInt(refs[t]);                            // Add the reference
+        out.put(' ');                                   // Add space at current index
+    }                                                   // End for loop
 
-        bool fault = false;
+    out.put('\n');                                      // Add new line
 
-        // If not present, FIFO must load it
-        if (position == -1)
-        {
-            fault = true;
-            pageFaults++;
-
-            // Look for an unused spot before replacing anything
-            int freeIndex = -1;
-            for (int i = 0; i < frameCount; i++) {
-                if (frames[i] == -1) {
-                    freeIndex = i;
-                    break;
-                }
-            }
+    out.reserve((size_t)refCount * 2 + 1);              // Room for the dashes
+    out.fill('-', (size_t)refCount * 2);                // Add two dashes per reference
+    out.put('\n');                                      // Add new line
 
-            if (freeIndex != -1) {
-                // There is still empty space then load page into the first empty frame
-                frames[freeIndex] = page;
-            }
-            else {
-                // No empty frame then move the oldest page 
-                frames[fifoIndex] = page;
+    for (int f = 0;                                     // Start for loop
+         f < frameCount;                                // While the index is less than the number of frames that can be used in the frame
+         f++) {                                         // Increment the index by one
 
-                // Move the FIFO pointer so the next eviction replaces the next oldest frame
-                fifoIndex = (fifoIndex + 1) % frameCount;
-            }
-        }
+        int page = -1;                                  // Page held by frame f so far
+        size_t e = 0;                                   // Next fault event to replay
 
-        // Only record the table state when the memory actually changed,
-        // on page faults
-        if (fault) {
-            for (int f = 0; f < frameCount; f++)
-                table[f][t] = frames[f];
-        }
-    }
+        out.reserve(rowBytes);                          // Room for this frame's row
+        for (int t = 0;                                 // Start for loop 
+             t < refCount;                              // While the index is less than the number of references in the input file
+             t++) {                                     // Increment the index by one
 
-    return pageFaults;
-}
+            if (e == log.size() || log[e].t != t) {     // No fault at this reference
+                out.put("  ");                          // Display space
+                continue;                               // Move on to the next reference
+            }                                           // End if statement
 
+            if (log[e].slot == f)                       // If this fault loaded frame f
+                page = log[e].loaded;                   // Frame f now holds the loaded page
+            e++;                                        // Advance to the next fault
 
-int OPT(int frameCount,
-        int refs[],
-        int refCount,
-        int table[][1000])
-{
-    std::cout << "Running OPT" << std::endl;
+            if (page == -1)                             // If the frame is still empty (blank)
+                out.put("  ");                          // Display space
+            else {                                      // Else
+                out.putInt(page);                       // Display the value at this point
+                out.put(' ');
+            }
 
-    int frames[50];
-    
-    // Initialize all memory frames as empty
-    // Each entry represents which page is currently stored in that frame
-    for (int i = 0; i < frameCount; i++) {
-        frames[i] = -1;
-    }
+        }                                               // End for loop
 
-    int pageFaults = 0;
+        out.put('\n');                                  // Add new line
 
-    // Step through each page request in order
-    // At each step, check if the requested page is already loaded
-    // If not loaded, OPT decides which page to evict based on future use
-    for (int t = 0; t < refCount; t++) {
+    }                                                   // End for loop
 
-        int page = refs[t];
+    out.flush();                                        // Write out the table
 
-        // Determine whether the page is already in memory
-        int pos = findPage(frames, frameCount, page);
+    std::cout << "Total page faults = " <<              // Display the message for the total number of faults
+        pageFaults << "\n";                             // Display total number of page faults
+}                                                       // End of printTable function
 
-        bool fault = false;
+/**
+ * @brief Runs a pager over a streamed trace
+ *
+ * @param reader The open trace, positioned after the header
+ * @param pager Any pager, or a WindowedOptPager
+ * @param refCount Receives the number of references consumed
+ *
+ * @return Number of page faults that occurred
+ */
 
-        if (pos == -1) {
+template <class Engine>
+long long streamPages(TraceReader &reader,
+                      Engine &pager,
+                      long long &refCount)
+{
+    PAGER_PHASE(PHASE_SIMULATE);                        // Reading is included, it is interleaved
 
-            fault = true;
-            pageFaults++;
+    int page;
 
-            int freeIndex = -1;
+    refCount = 0;
+    while (reader.next(page)) {
+        pager.access(page);
+        refCount++;
+    }
 
-            // Look for an unused frame first
-            // If one exists, load the page into that slot and continue
-            for (int i = 0; i < frameCount; i++) {
-                if (frames[i] == -1) {
-                    freeIndex = i;
-                    break;
-                }
-            }
+    return pager.pageFaults;
+}
 
-            // Case 1: There is an empty frame then load page there
-            if (freeIndex != -1) {
-                frames[freeIndex] = page;
-            }
+/**
+ * @brief Runs a FIFO or LRU pager over a streamed trace, saving a
+ *        checkpoint every checkpoint.interval() references
+ *
+ * @param reader The open trace, positioned after the header or at the
+ *               saved offset
+ * @param pager A FIFO or LRU pager, fresh or restored from a checkpoint
+ * @param position The scenario's position; refCount counts on from it
+ * @param checkpoint Where to save
+ *
+ * @return Number of page faults that occurred
+ */
 
-            // Case 2: No empty frame then choose a page using OPT logic
-            else {
-
-                int replaceIndex = 0;
-                int farthestUse = -1;
-
-                // For every page currently loaded, determine when it will next be used
-                // The page whose next use is farthest in the future (or never used again)
-                // is the optimal page to evict
-                for (int i = 0; i < frameCount; i++) {
-
-                    int currentPage = frames[i];
-                    int nextUse = -1;
-
-                    // Scan forward in the reference string to find when this page is next referenced
-                    for (int j = t + 1; j < refCount; j++) {
-                        if (refs[j] == currentPage) {
-                            nextUse = j;
-                            break;
-                        }
-                    }
-
-                    // If a page is never used again it is the optimal eviction target immediately
-                    if (nextUse == -1) {
-                        replaceIndex = i;
-                        farthestUse = refCount + 1;  // Marker meaning "never used again"
-                        break;
-                    }
-
-                    // Otherwise track the page with the farthest next occurrence
-                    else if (nextUse > farthestUse) {
-                        farthestUse = nextUse;
-                        replaceIndex = i;
-                    }
-                }
-
-                // Evict the chosen page and load the requested one
-                frames[replaceIndex] = page;
+template <class Engine>
+long long streamPagesCheckpointed(TraceReader &reader,
+                                  Engine &pager,
+                                  StreamPosition &position,
+                                  Checkpoint &checkpoint)
+{
+    PAGER_PHASE(PHASE_SIMULATE);                        // Reading is included, it is interleaved
+
+    int page;
+    long long due = position.refCount + checkpoint.interval();   // When the next snapshot is due
+
+    while (reader.next(page)) {
+        pager.access(page);
+        if (++position.refCount == due) {
+            position.offset = reader.offset();          // Resume right after this reference
+            position.line = reader.line();
+            if (!checkpoint.save(position, pager)) {
+                std::cerr << "Cannot write checkpoint file.\n";
+                std::exit(1);
             }
+            due += checkpoint.interval();
         }
+    }
+
+    return pager.pageFaults;
+}
+
+/**
+ * @brief Prints the line that separates scenarios of a multi-line input
+ *
+ * @param scenario 1-based scenario number
+ * @param line Line of the input file the scenario came from
+ */
+
+void printScenarioHeader(int scenario,
+                         int line)
+{
+    std::cout << "=== Scenario " << scenario <<      // Scenario number
+        " (line " << line << ") ===\n";                // Where it came from
+}
+
+/**
+ * @brief Runs any algorithm over the rest of the current scenario line
+ *
+ * OPT cannot see the whole future of a stream, so it looks ahead window
+ * references instead (see window.h).
+ *
+ * @param reader The open trace, positioned after the header
+ * @param algo The algorithm code from the header
+ * @param frameCount The frame count from the header
+ * FIFO and LRU save checkpoints as they go when checkpoint is given, and
+ * continue from resumeState when it is given.
+ *
+ * @param window OPT's look-ahead in references
+ * @param checkpoint Where to save checkpoints, or nullptr
+ * @param position The scenario's position, kept up to date for checkpoints
+ * @param resumeState Pager state to continue from, or nullptr to start afresh
+ * @param refCount Receives the number of references consumed
+ * @param pageFaults Receives the number of page faults
+ *
+ * @return An error message, or nullptr on success
+ */
 
-        // Only record table state when a fault occurred
-        // This captures the "visual" of how frames changed due to OPT decisions
-        if (fault) {
-            for (int f = 0; f < frameCount; f++) {
-                table[f][t] = frames[f];
+const char *streamScenario(TraceReader &reader,
+                           char algo,
+                           int frameCount,
+                           int window,
+                           Checkpoint *checkpoint,
+                           StreamPosition &position,
+                           const std::vector<char> *resumeState,
+                           long long &refCount,
+                           long long &pageFaults)
+{
+    refCount = 0;
+    pageFaults = 0;
+
+    if (frameCount < 1)                                 // A pager needs at least one frame
+        return "Frame count must be at least 1.\n";
+
+    if (checkpoint &&                                   // FIFO and LRU can be checkpointed
+        (algo == 'F' || algo == 'f' || algo == 'L' || algo == 'l')) {
+        auto run = [&](auto &pager) -> const char * {
+            if (resumeState) {                          // Pick up where the snapshot left off
+                StateReader in(resumeState->data(), resumeState->size());
+                if (!pager.loadState(in))
+                    return "Checkpoint file is damaged.\n";
             }
+            pageFaults = streamPagesCheckpointed(reader, pager, position, *checkpoint);
+            refCount = position.refCount;
+            return nullptr;
+        };
+
+        if (algo == 'L' || algo == 'l') {
+            LruPager pager(frameCount);
+            return run(pager);
         }
+        FifoPager pager(frameCount);
+        return run(pager);
     }
 
-    return pageFaults;
+    if (algo == 'O' || algo == 'o') {                   // OPT only sees the next window references
+        WindowedOptPager pager(frameCount, window);
+        streamPages(reader, pager, refCount);
+        pageFaults = pager.finish();                    // Simulate the references still queued
+        return nullptr;
+    }
+
+    bool known = visitOnlinePager(algo, frameCount,     // Every other algorithm runs online
+                                  [&](auto &pager) {
+        pageFaults = streamPages(reader, pager, refCount);
+    });
+
+    if (known)                                          // The pager consumed the line
+        return nullptr;
+
+    return "Unknown algorithm code.\n";
 }
 
 /**
- * @brief Runs the LRU algorithm, which will remove the least recently used page from memory when a new page fault occurs
+ * @brief Runs any algorithm while reading the trace, without holding it
+ *
+ * Memory depends only on the frame count (plus the look-ahead window for
+ * OPT), so traces of any length can be simulated. No table is printed
+ * since it would grow with the trace. Every non-blank line of the input
+ * is run as its own scenario.
+ *
+ * With a checkpoint, snapshots are saved during FIFO and LRU scenarios and
+ * after every scenario, and removed when the whole input is done. With
+ * resume as well, the run continues from the snapshot if there is one:
+ * finished scenarios are skipped and the results printed are the same as
+ * those of an uninterrupted run.
+ *
+ * @param filename The input file, or "-" for standard input
+ * @param window OPT's look-ahead in references
+ * @param checkpoint Where to save checkpoints, or nullptr
+ * @param resume Whether to continue from the checkpoint file
+ *
+ * @return Exit status for main
  */
 
-int LRU(int frameCount,
-        int refs[],
-        int refCount,
-        int table[][1000])
+int runStream(const char *filename,
+              int window,
+              Checkpoint *checkpoint,
+              bool resume)
 {
-    std::cout << "Running LRU" << std::endl;
-
-    int frames[50];     
-    int lastUsed[50];  
+    TraceReader reader(filename);                       // Open the trace for chunked reading
 
-    // Initialize all frames as empty and mark every frame as never used
-    for (int i = 0; i < frameCount; i++) {
-        frames[i] = -1;
-        lastUsed[i] = -1;
+    if (reader.startsWith("PGTR", 4)) {                 // Written by --convert, not text
+        std::cerr << "Cannot stream a binary trace; use any other mode.\n";
+        return 1;
     }
 
-    int pageFaults = 0;
+    StreamPosition position = {0, 0, 1, 1, 0, 0};       // Where the run is
+    std::vector<char> resumeState;                      // Pager state saved mid-scenario
+    bool resumed = resume &&                            // Continue from an earlier run
+        readCheckpoint(checkpoint->path(), position, resumeState);
 
-    // Process each page reference in order
-    // At each time step t, decide whether the page exists
-    // or must be brought into memory
-    for (int t = 0; t < refCount; t++) {
+    if (resumed) {
+        if (!reader.seek(position.offset, position.line)) {
+            std::cerr << "Cannot resume from standard input.\n";
+            return 1;
+        }
+    }
+    else if (!reader.firstScenario()) {                 // Find the first scenario line
+        std::cerr << "Input file is empty.\n";          // Print error message
+        return 1;                                       // Return 1
+    }                                                   // End if statement
 
-        int page = refs[t];
+    int status = 0;                                     // Exit status
+    bool multi = position.scenario > 1;                 // Whether the input has several scenarios
+    bool more;                                          // Whether another scenario follows
 
-        // Check whether the requested page is already loaded
-        int position = findPage(frames, frameCount, page);
+    for (int scenario = position.scenario; ; scenario++) { // One pass per scenario line
+        int line = reader.line();                       // Line the scenario starts on
 
-        bool fault = false;
+        char algo;                                      // Algorithm to be used
+        int frameCount;                                 // Frame count that can be used
+        const std::vector<char> *state = nullptr;       // Pager state to continue from
 
-        if (position != -1) {
-            // Page is already in memory
-            // Update the "last used" timestamp to reflect recent access
-            lastUsed[position] = t;
-        } 
+        if (resumed && position.algo) {                 // Mid-scenario: the header was read before
+            algo = position.algo;
+            frameCount = position.frameCount;
+            state = &resumeState;
+        }
         else {
-            // Page is missing then this is a page fault
-            fault = true;
-            pageFaults++;
-
-            // First try to find an unused empty frame
-            int freeIndex = -1;
-            for (int i = 0; i < frameCount; i++) {
-                if (frames[i] == -1) {
-                    freeIndex = i;
-                    break;
-                }
-            }
+            reader.readHeader(algo, frameCount);        // Read the algorithm code and frame count
+            position = {algo, frameCount, scenario, line, 0, 0};
+        }
+        resumed = false;
 
-            if (freeIndex != -1) {
-                // If an empty frame exists, load the page there
-                frames[freeIndex] = page;
-                lastUsed[freeIndex] = t;
-            } 
-            else {
-                // No empty frames then choose the least recently used page
-                // Scan all frames and pick the one with the oldest timestamp
-                int lruIndex = 0;
-                int oldest = lastUsed[0];
-
-                for (int i = 1; i < frameCount; i++) {
-                    if (lastUsed[i] < oldest) {
-                        oldest = lastUsed[i];
-                        lruIndex = i;
-                    }
-                }
-
-                // Replace the LRU page with the new page
-                // and update its usage timestamp
-                frames[lruIndex] = page;
-                lastUsed[lruIndex] = t;
-            }
+        long long refCount, pageFaults;                 // Results of the run
+        const char *error = streamScenario(reader, algo, frameCount, window,
+                                           checkpoint, position, state,
+                                           refCount, pageFaults);
+
+        more = reader.nextScenario();                   // Look for another scenario line
+        multi = multi || more;                          // Label every scenario once there are several
+        if (multi)
+            printScenarioHeader(scenario, line);
+
+        if (error) {                                    // Report a bad scenario and carry on
+            std::cerr << error;
+            status = 1;
+        }
+        else {
+            std::cout << "Running " << algorithmName(algo);
+            if (algo == 'O' || algo == 'o')             // Not the true OPT unless the window covers the trace
+                std::cout << " (window = " << window << ")";
+            std::cout << "\n";
+            std::cout << "Total references = " <<      // Display the number of references read
+                refCount << "\n";
+            std::cout << "Total page faults = " <<      // Display the message for the total number of faults
+                pageFaults << "\n";                     // Display total number of page faults
         }
 
-        // If a fault occurred this step,
-        // record the current frame contents in the display table
-        if (fault) {
-            for (int f = 0; f < frameCount; f++) {
-                table[f][t] = frames[f];
+        if (checkpoint && more) {                       // Resume at the next scenario from here on
+            std::cout.flush();                          // This scenario's results are out first
+            StreamPosition next = {0, 0, scenario + 1, reader.line(), reader.offset(), 0};
+            if (!checkpoint->save(next)) {
+                std::cerr << "Cannot write checkpoint file.\n";
+                return 1;
             }
         }
+
+        if (!more)                                      // Stop after the last scenario
+            break;
     }
 
-    // Return the total number of faults observed
-    return pageFaults;
-}
+    if (checkpoint)                                     // Nothing left to resume
+        checkpoint->finish();
 
+    return status;
+}
 
 /**
- * @brief Prints the table to stdout
- * 
+ * @brief Prints the LRU page faults for every frame count up to maxFrames
+ *
  * @param refs[] Array of references from input file
  * @param refCount Number of references in input file
- * @param frameCount Number of frames allowed to be used per
- * @param table[][] Table to print
- * @param pageFaults Number of page faults that occurred
+ * @param maxFrames Largest frame count to report
  */
 
-void printTable(int refs[],
+void printCurve(const int refs[],
                 int refCount,
-                int frameCount,
-                int table[][1000],
-                int pageFaults)
+                int maxFrames)
 {
+    PAGER_PHASE(PHASE_OUTPUT);                          // The curve itself is timed as simulation
 
-    for (int t = 0;                                     // Start for loop
-         t < refCount;                                  // While the index is less than the number of references in the input file
-         t++) {                                         // Increment the index by one
+    std::cout << "Running LRU stack distance" << "\n";
 
-        std::cout << refs[t] << " ";                    // Add space at current index
-    }                                                   // End for loop        
+    std::vector<long long> faults =                     // Faults for each frame count
+        stackDistanceFaults(refs, refCount, maxFrames);
 
-    std::cout << "\n";                                  // Add new line
+    std::cout << "Frames Faults\n";                     // Table heading
+    for (int c = 1;                                     // Start for loop
+         c <= maxFrames;                                // Every frame count up to maxFrames
+         c++) {                                         // Increment the frame count
 
-    for (int t = 0;                                     // Start for loop
-         t < refCount * 2;                              // While the index is less than twice the number of references in the input file
-         t++) {                                         // Increment the index by one
-        std::cout << "-";                               // Add dash at current index
+        std::cout << c << " " << faults[c] << "\n";     // One row per frame count
     }                                                   // End for loop
+}
 
-    std::cout << "\n";                                  // Add new line
-    
-    for (int f = 0;                                     // Start for loop
-         f < frameCount;                                // While the index is less than the number of frames that can be used in the frame
-         f++) {                                         // Increment the index by one
+/**
+ * @brief Prints SHARDS estimates of the LRU page faults for every frame
+ *        count up to maxFrames
+ *
+ * With verify, the exact curve is computed as well and the miss-ratio
+ * error of the estimate is reported. The exact curve needs memory for
+ * every distinct page, so it is only computed when asked for.
+ *
+ * @param refs[] Array of references from input file
+ * @param refCount Number of references in input file
+ * @param maxFrames Largest frame count to report
+ * @param rate Starting sampling rate
+ * @param maxSamples Most pages the sampler may track
+ * @param verify Whether to compare against the exact curve
+ */
 
-        for (int t = 0;                                 // Start for loop 
-             t < refCount;                              // While the index is less than the number of references in the input file
-             t++) {                                     // Increment the index by one
+void printShardsCurve(const int refs[],
+                      int refCount,
+                      int maxFrames,
+                      double rate,
+                      int maxSamples,
+                      bool verify)
+{
+    PAGER_PHASE(PHASE_OUTPUT);                          // The sampling is timed as simulation
+
+    std::cout << "Running LRU SHARDS" << "\n";
+
+    ShardsSampler sampler(maxFrames, rate, maxSamples); // Fixed-size sampler
+    {
+        PAGER_PHASE(PHASE_SIMULATE);                    // Time the sampling on its own
 
-            if (table[f][t] == -1)                      // If table is equal to -1 (blank)
-                std::cout << "  ";                      // Display space
-            else                                        // Else
-                std::cout << table[f][t] << " ";        // Display the value at this point
+        for (int t = 0;                                 // Start for loop
+             t < refCount;                              // Every reference
+             t++) {                                     // Increment the index
 
+            sampler.access(refs[t]);                    // Feed the sampler
         }                                               // End for loop
+    }
+
+    std::vector<long long> faults = sampler.faults();   // Estimated faults per frame count
+    std::vector<long long> exact;                       // Exact faults per frame count
+    if (verify)
+        exact = stackDistanceFaults(refs, refCount, maxFrames);
+
+    std::cout << "Sampling rate = " << sampler.rate() << // Rate after any lowering
+        ", sampled pages = " << sampler.sampledPages() << "\n";
+
+    std::cout << (verify ? "Frames Faults Exact\n" :    // Table heading
+                           "Frames Faults\n");
+
+    double totalError = 0;                              // Sum of miss-ratio errors
+    double maxError = 0;                                // Largest miss-ratio error
+    for (int c = 1;                                     // Start for loop
+         c <= maxFrames;                                // Every frame count up to maxFrames
+         c++) {                                         // Increment the frame count
+
+        std::cout << c << " " << faults[c];             // Estimated faults
+        if (verify) {
+            std::cout << " " << exact[c];               // Exact faults
+            double error = refCount ? std::fabs((double)(faults[c] - exact[c])) / refCount : 0;
+            totalError += error;
+            if (error > maxError)
+                maxError = error;
+        }
+        std::cout << "\n";
+    }                                                   // End for loop
 
-        std::cout << "\n";                              // Add new line
+    if (verify) {                                       // Summarize the error over the curve
+        std::cout << "Mean miss-ratio error = " << totalError / maxFrames << "\n";
+        std::cout << "Max miss-ratio error = " << maxError << "\n";
+    }
+}
 
+/**
+ * @brief Prints one power-of-two histogram, one row per bucket up to the
+ *        last non-empty one
+ *
+ * @param hist Counts by bucket (bucket k holds values 2^k..2^(k+1)-1)
+ * @param refCount Number of references, for the LRU hit ratio column
+ * @param hitRatio Whether to print the LRU hit ratio column
+ */
+
+void printHistogram(const std::vector<long long> &hist,
+                    long long refCount,
+                    bool hitRatio)
+{
+    int last = hist.size() - 1;                         // Last non-empty bucket
+    while (last >= 0 && hist[last] == 0)
+        last--;
+
+    long long hits = 0;                                 // References with a smaller value
+    for (int k = 0;                                     // Start for loop
+         k <= last;                                     // Every bucket up to the last used one
+         k++) {                                         // Increment the bucket
+
+        long long low = 1LL << k;                       // Smallest value in the bucket
+        long long high = (low << 1) - 1;                // Largest value in the bucket
+        if (low == high)
+            std::cout << low;
+        else
+            std::cout << low << "-" << high;
+        std::cout << " " << hist[k];
+
+        if (hitRatio) {                                 // LRU with high frames hits all of these
+            hits += hist[k];
+            char ratioText[32];
+            std::snprintf(ratioText, sizeof ratioText, "%.4f",
+                          refCount ? (double)hits / refCount : 0.0);
+            std::cout << " " << ratioText;
+        }
+        std::cout << "\n";
     }                                                   // End for loop
+}
 
-    std::cout << "Total page faults = " <<              // Display the message for the total number of faults
-        pageFaults << "\n";                             // Display total number of page faults
-}                                                       // End of printTable function
+/**
+ * @brief Prints the statistics of a trace
+ *
+ * The LRU hit ratio column gives the hit ratio of LRU with as many frames
+ * as the largest distance in the row, read off the stack distances.
+ *
+ * @param refs[] Array of references from input file
+ * @param refCount Number of references in input file
+ */
+
+void printAnalysis(const int refs[],
+                   int refCount)
+{
+    PAGER_PHASE(PHASE_OUTPUT);                          // The analysis is timed as simulation
+
+    std::cout << "Running trace analysis" << "\n";
+
+    TraceStats stats = analyzeTrace(refs, refCount);    // Everything in one pass
+
+    char ratioText[32];                                 // One-hit wonders per distinct page
+    std::snprintf(ratioText, sizeof ratioText, "%.4f",
+                  stats.distinct ? (double)stats.oneHitWonders / stats.distinct : 0.0);
+
+    std::cout << "Total references = " << stats.references << "\n";
+    std::cout << "Distinct pages = " << stats.distinct << "\n";
+    std::cout << "One-hit wonders = " << stats.oneHitWonders << "\n";
+    std::cout << "One-hit wonder ratio = " << ratioText << "\n";
+
+    std::cout << "Stack distance histogram\n";         // Re-references by LRU stack distance
+    std::cout << "Distance References LRUHitRatio\n";
+    printHistogram(stats.distanceHist, stats.references, true);
+    std::cout << "Cold " << stats.distinct << "\n";    // First references have no distance
+
+    std::cout << "Reference gap histogram\n";          // Re-references by time since the last use
+    std::cout << "Gap References\n";
+    printHistogram(stats.gapHist, stats.references, false);
+    std::cout << "Cold " << stats.distinct << "\n";
+}
+
+/**
+ * @brief Prints the per-tier results of a memory hierarchy
+ *
+ * HitRatio is local: hits over the references that reached the tier.
+ *
+ * @param refs[] Array of references from input file
+ * @param refCount Number of references in input file
+ * @param tiers The tiers, fastest first
+ * @param exclusive Exclusive rather than inclusive tiers
+ * @param memoryLatency Cost of a reference no tier holds (0 = ten times the last tier)
+ */
+
+void printHierarchy(const int refs[],
+                    int refCount,
+                    const std::vector<TierSpec> &tiers,
+                    bool exclusive,
+                    double memoryLatency)
+{
+    PAGER_PHASE(PHASE_OUTPUT);                          // The hierarchy is timed as simulation
+
+    if (memoryLatency == 0)                             // Memory is one step below the last tier
+        memoryLatency = tiers.back().latency * 10;
+
+    std::cout << "Running hierarchy (" <<
+        (exclusive ? "exclusive" : "inclusive") << ")\n";
+
+    HierarchyResult result = runHierarchy(refs, refCount, tiers, exclusive, memoryLatency);
+
+    std::cout << "Tier Algorithm Frames Hits Faults HitRatio Latency\n";
+    for (size_t i = 0; i < tiers.size(); i++) {         // One row per tier, fastest first
+        const TierStats &stats = result.tiers[i];
+        long long reached = stats.hits + stats.faults;  // References looked up in this tier
+
+        char ratioText[32];
+        std::snprintf(ratioText, sizeof ratioText, "%.4f",
+                      reached ? (double)stats.hits / reached : 0.0);
+
+        std::cout << i + 1 << " " << algorithmName(tiers[i].algo) << " " <<
+            tiers[i].frameCount << " " << stats.hits << " " << stats.faults << " " <<
+            ratioText << " " << tiers[i].latency << "\n";
+    }
+
+    char latencyText[32];                               // Mean cost per reference, 4 decimals
+    std::snprintf(latencyText, sizeof latencyText, "%.4f", result.averageLatency);
+
+    std::cout << "Total references = " << refCount << "\n";
+    std::cout << "Memory accesses = " << result.memoryAccesses << "\n";
+    std::cout << "Memory latency = " << memoryLatency << "\n";
+    std::cout << "Average access latency = " << latencyText << "\n";
+}
+
+/**
+ * @brief Prints one row of the cost model table
+ */
+
+void printCostRow(const char *name,
+                  int frameCount,
+                  const CostResult &result)
+{
+    char costText[32];                                  // Total cost, 2 decimals
+    std::snprintf(costText, sizeof costText, "%.2f", result.cost);
+
+    std::cout << name << " " << frameCount << " " << result.hits << " " <<
+        result.faults << " " << result.writeBacks << " " << result.dirtyAtEnd << " " <<
+        costText << "\n";
+}
+
+/**
+ * @brief Prints the estimated I/O cost of the algorithm in the input line,
+ *        and of its cost-aware variant if it has one
+ *
+ * @param trace The scenario's trace, with write flags if the input had them
+ * @param model What hits, faults and write-backs cost
+ * @param cleanWindow CFLRU: frames in the clean-first region (0 = a quarter)
+ *
+ * @return 0 on success, 1 for an unknown algorithm
+ */
+
+int printCost(const Trace &trace,
+              const CostModel &model,
+              int cleanWindow)
+{
+    PAGER_PHASE(PHASE_OUTPUT);                          // The runs are timed as simulation
+
+    const char *name = algorithmName(trace.algo);       // Full name of the algorithm
+    if (!name) {                                        // Anything else is not a known algorithm
+        std::cerr << "Unknown algorithm code.\n";
+        return 1;
+    }
+
+    const char *writes = trace.writes.empty() ?         // Binary traces carry no write flags
+        nullptr : trace.writes.data();
+    long long writeCount = 0;                           // References that write
+    for (size_t t = 0; t < trace.writes.size(); t++)
+        writeCount += trace.writes[t];
+
+    std::cout << "Running cost model" << "\n";
+    std::cout << "Hit cost = " << model.hit << ", fault cost = " << model.fault <<
+        ", write-back cost = " << model.writeBack << "\n";
+    std::cout << "Total references = " << trace.refCount << "\n";
+    std::cout << "Writes = " << writeCount << "\n";
+    std::cout << "Algorithm Frames Hits Faults WriteBacks DirtyAtEnd Cost\n";
+
+    CostResult result;
+    runCostModel(trace.algo, false, trace.frameCount, trace.refs, writes,
+                 trace.refCount, model, cleanWindow, result);
+    printCostRow(name, trace.frameCount, result);
+
+    if (costAwareName(trace.algo)) {                    // LRU and OPT have a cost-aware variant
+        runCostModel(trace.algo, true, trace.frameCount, trace.refs, writes,
+                     trace.refCount, model, cleanWindow, result);
+        printCostRow(costAwareName(trace.algo), trace.frameCount, result);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Prints one variable-allocation run: the frames allocated over
+ *        time, then the totals
+ */
+
+void printVariableRun(const VariableResult &result,
+                      int refCount)
+{
+    std::cout << "References Frames Faults\n";
+    for (size_t i = 0; i < result.timeline.size(); i++) { // One row per sample
+        const AllocationSample &sample = result.timeline[i];
+        std::cout << sample.time << " " << sample.frames << " " << sample.faults << "\n";
+    }
+
+    char averageText[32];                               // Mean frames allocated, 4 decimals
+    std::snprintf(averageText, sizeof averageText, "%.4f", result.averageFrames);
+
+    std::cout << "Total references = " << refCount << "\n";
+    std::cout << "Total page faults = " << result.faults << "\n";
+    std::cout << "Average resident set = " << averageText << "\n";
+    std::cout << "Peak resident set = " << result.peakFrames << "\n";
+}
+
+/**
+ * @brief Prints the working-set model for each window, then PFF
+ *
+ * @param refs[] Array of references from input file
+ * @param refCount Number of references in input file
+ * @param taus Working-set windows to run (may be empty)
+ * @param pffLower PFF: fault rate below which pages are released (negative = no PFF run)
+ * @param pffUpper PFF: fault rate above which the allocation grows
+ * @param interval References between timeline rows (0 = a twentieth of the trace)
+ */
+
+void printVariable(const int refs[],
+                   int refCount,
+                   const std::vector<int> &taus,
+                   double pffLower,
+                   double pffUpper,
+                   int interval)
+{
+    PAGER_PHASE(PHASE_OUTPUT);                          // The runs are timed as simulation
+
+    if (interval <= 0)                                  // About twenty rows by default
+        interval = (refCount + 19) / 20;
+    if (interval <= 0)
+        interval = 1;
+
+    for (size_t i = 0; i < taus.size(); i++) {          // One run per window
+        std::cout << "Running working set (tau = " << taus[i] << ")\n";
+        printVariableRun(runWorkingSet(refs, refCount, taus[i], interval), refCount);
+    }
+
+    if (pffLower >= 0) {                                // Thresholds given
+        std::cout << "Running PFF (lower = " << pffLower << ", upper = " << pffUpper << ")\n";
+        printVariableRun(runPff(refs, refCount, pffLower, pffUpper, interval), refCount);
+    }
+}
+
+/**
+ * @brief Runs every (algorithm, frame count) pair over the trace in parallel
+ *
+ * Prints one CSV row per job, in algorithm-then-frame-count order.
+ *
+ * @param refs[] Array of references from input file
+ * @param refCount Number of references in input file
+ * @param algos Algorithm codes to run
+ * @param frameCounts Frame counts to run each algorithm with
+ * @param threadCount Number of worker threads (0 = one per core)
+ *
+ * @return Exit status for main
+ */
+
+int runBatchMode(const int refs[],
+                 int refCount,
+                 const std::string &algos,
+                 const std::vector<int> &frameCounts,
+                 int threadCount)
+{
+    PAGER_PHASE(PHASE_OUTPUT);                          // The jobs are timed as simulation
+
+    for (size_t a = 0; a < algos.size(); a++) {         // Check every algorithm code up front
+        if (!algorithmName(algos[a])) {
+            std::cerr << "Unknown algorithm code.\n";
+            return 1;
+        }
+    }
+
+    std::vector<BatchJob> jobs =                        // One job per algorithm and frame count
+        makeJobs(algos, frameCounts);
+
+    runBatch(refs, refCount, jobs, threadCount);        // Run them on the worker threads
+
+    std::cout << "Algorithm,Frames,Faults\n";           // CSV heading
+    for (size_t j = 0; j < jobs.size(); j++) {          // One row per job, in job order
+        std::cout << algorithmName(jobs[j].algo) << "," <<
+            jobs[j].frameCount << "," <<
+            jobs[j].pageFaults << "\n";
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes the trace out in binary form
+ *
+ * @param trace The loaded trace
+ * @param filename The binary trace file to write
+ * @param encoding How to store the references
+ *
+ * @return Exit status for main
+ */
+
+int runConvert(const Trace &trace,
+               const char *filename,
+               TraceEncoding encoding)
+{
+    size_t bytes = writeBinaryTrace(filename, trace.algo, trace.frameCount,
+                                    trace.refs, trace.refCount, encoding);
+    if (bytes == 0) {
+        std::cerr << "Cannot write output file.\n";
+        return 1;
+    }
+
+    std::cout << "Wrote " << trace.refCount << " references in " <<
+        bytes << " bytes\n";
+    return 0;
+}
+
+/**
+ * @brief What main() was asked to do with each scenario
+ */
+
+enum RunMode { MODE_TABLE, MODE_STREAM, MODE_CURVE, MODE_SHARDS, MODE_BATCH, MODE_CONVERT,
+               MODE_SUMMARY, MODE_ANALYZE, MODE_HIERARCHY, MODE_COST, MODE_SERVE,
+               MODE_VARIABLE };
+
+enum OutputFormat { FORMAT_TEXT, FORMAT_CSV, FORMAT_JSON };
+
+struct RunOptions {
+    RunMode mode;                                       // What to do with the trace
+    const char *policies;                               // Batch: algorithm codes to run
+    const char *frameSpec;                              // Batch: frame counts to run
+    int threadCount;                                    // Batch and parsing: worker threads (0 = one per core)
+    double sampleRate;                                  // SHARDS: starting sampling rate
+    int maxSamples;                                     // SHARDS: most pages tracked at once
+    bool verify;                                        // SHARDS: also compute the exact curve
+    int window;                                         // Stream: OPT's look-ahead in references
+    const char *checkpointFile;                         // Stream: where to save checkpoints
+    long long checkpointEvery;                          // Stream: references between checkpoints
+    bool resume;                                        // Stream: continue from the checkpoint
+    const char *tierSpec;                               // Hierarchy: the tiers, fastest first
+    bool exclusive;                                     // Hierarchy: exclusive rather than inclusive
+    double memoryLatency;                               // Hierarchy: cost of a memory access (0 = default)
+    CostModel costs;                                    // Cost: what hits, faults and write-backs cost
+    int cleanWindow;                                    // Cost: CFLRU's clean-first region (0 = default)
+    const char *tauSpec;                                // Variable: working-set windows (nullptr = none)
+    double pffLower;                                    // Variable: PFF's lower fault rate (negative = no PFF)
+    double pffUpper;                                    // Variable: PFF's upper fault rate
+    int interval;                                       // Variable: references between timeline rows (0 = default)
+    OutputFormat format;                                // Summary: how to print the totals
+};
+
+/**
+ * @brief Runs a scenario and prints only its totals
+ *
+ * The time covers the simulation itself (including remapping the pages),
+ * not reading the input.
+ *
+ * @param trace The scenario's trace
+ * @param format Plain text, one CSV row, or one JSON object per line
+ *
+ * @return 0 on success, 1 for an unknown algorithm
+ */
+
+int printSummary(const Trace &trace,
+                 OutputFormat format)
+{
+    const char *name = algorithmName(trace.algo);       // Full name of the algorithm
+    if (!name) {                                        // Anything else is not a known algorithm
+        std::cerr << "Unknown algorithm code.\n";
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start =       // Start the clock
+        std::chrono::steady_clock::now();
+
+    RunVector<int> dense;                               // The trace with pages numbered 0..U-1
+    RunVector<int> original;                            // Original number of each dense page
+    remapTrace(trace.refs, trace.refCount, dense, original);
+    long long pageFaults = countFaults<DenseIndex>(trace.algo, trace.frameCount,
+                                                   dense.data(), trace.refCount);
+
+    double seconds = std::chrono::duration<double>(     // Stop the clock
+        std::chrono::steady_clock::now() - start).count();
+
+    double hitRatio = trace.refCount ?                  // Share of references that hit
+        1 - (double)pageFaults / trace.refCount : 0;
+
+    char ratioText[32];                                 // Hit ratio, 4 decimals
+    char secondsText[32];                               // Time, microsecond resolution
+    std::snprintf(ratioText, sizeof ratioText, "%.4f", hitRatio);
+    std::snprintf(secondsText, sizeof secondsText, "%.6f", seconds);
+
+    if (format == FORMAT_CSV) {                         // Row for the header printed by main
+        std::cout << name << "," << trace.frameCount << "," << trace.refCount << "," <<
+            pageFaults << "," << ratioText << "," << secondsText << "\n";
+    }
+    else if (format == FORMAT_JSON) {                   // One object per scenario
+        std::cout << "{\"algorithm\":\"" << name << "\",\"frames\":" << trace.frameCount <<
+            ",\"references\":" << trace.refCount << ",\"faults\":" << pageFaults <<
+            ",\"hit_ratio\":" << ratioText << ",\"seconds\":" << secondsText << "}\n";
+    }
+    else {                                              // Plain text, like stream mode
+        std::cout << "Running " << name << "\n";
+        std::cout << "Total references = " << trace.refCount << "\n";
+        std::cout << "Total page faults = " << pageFaults << "\n";
+        std::cout << "Hit ratio = " << ratioText << "\n";
+        std::cout << "Time = " << secondsText << " s\n";
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Runs one scenario in table, summary, curve, batch, analysis,
+ *        hierarchy, cost or variable-allocation mode
+ *
+ * @param trace The scenario's trace
+ * @param options The command line options
+ *
+ * @return 0 on success, 1 if the scenario could not be run
+ */
+
+int runScenario(const Trace &trace,
+                const RunOptions &options)
+{
+    int frameCount = trace.frameCount;                  // Frame count that can be used
+    char algo = trace.algo;                             // Algorithm to be used
+    const int *refs = trace.refs;                       // Reference array
+    int refCount = trace.refCount;                      // Number of references from the input
+
+    FaultLog faultLog;                                  // Faults recorded for the table
+
+    if (options.mode == MODE_ANALYZE) {                 // Statistics need no algorithm or frames
+        printAnalysis(refs, refCount);
+        return 0;
+    }
+
+    if (options.mode == MODE_HIERARCHY) {               // The tiers replace algorithm and frames
+        std::vector<TierSpec> tiers;
+        if (!parseTierList(options.tierSpec, tiers)) {
+            std::cerr << "Bad tier list.\n";
+            return 1;
+        }
+
+        printHierarchy(refs, refCount, tiers, options.exclusive, options.memoryLatency);
+        return 0;
+    }
+
+    if (options.mode == MODE_VARIABLE) {                // Memory is sized as the run goes
+        std::vector<int> taus;
+        if (options.tauSpec && !parseFrameList(options.tauSpec, taus)) {
+            std::cerr << "Bad working-set window list.\n";
+            return 1;
+        }
+
+        printVariable(refs, refCount, taus, options.pffLower, options.pffUpper,
+                      options.interval);
+        return 0;
+    }
+
+    if (frameCount < 1) {                               // A pager needs at least one frame
+        std::cerr << "Frame count must be at least 1.\n";
+        return 1;
+    }
+
+    if (options.mode == MODE_CURVE) {                   // Curve mode reports every size up to frameCount
+        printCurve(refs, refCount, frameCount);
+        return 0;
+    }
+
+    if (options.mode == MODE_SUMMARY)                   // Totals only, no table
+        return printSummary(trace, options.format);
+
+    if (options.mode == MODE_COST)                      // I/O cost rather than faults
+        return printCost(trace, options.costs, options.cleanWindow);
+
+    if (options.mode == MODE_SHARDS) {                  // Sampled curve up to frameCount
+        printShardsCurve(refs, refCount, frameCount,
+                         options.sampleRate, options.maxSamples, options.verify);
+        return 0;
+    }
+
+    if (options.mode == MODE_BATCH) {                   // Batch defaults to the input line
+        std::vector<int> frameCounts;
+        std::string frameList = options.frameSpec ? options.frameSpec :
+            "1-" + std::to_string(frameCount);
+        if (!parseFrameList(frameList, frameCounts)) {
+            std::cerr << "Bad frame list.\n";
+            return 1;
+        }
+
+        return runBatchMode(refs, refCount,
+                            options.policies ? options.policies : std::string(1, algo),
+                            frameCounts, options.threadCount);
+    }
+
+    RunVector<int> dense;                               // The trace with pages numbered 0..U-1
+    RunVector<int> original;                            // Original number of each dense page
+    remapTrace(refs, refCount, dense, original);        // Lets the engine index pages directly
+
+    long long pageFaults = runAlgorithm<DenseIndex>(    // Run the algorithm named in the input
+        algo,                                           // Algorithm code
+        frameCount,                                     // Frame count
+        dense.data(),                                   // Remapped reference array
+        refCount,                                       // Number of refs from the input line
+        &faultLog);                                     // The fault log for displaying
+
+    if (pageFaults < 0) {                               // Anything else is not a known algorithm
+        std::cerr << "Unknown algorithm code.\n";       // Print error message
+        return 1;                                       // Return 1
+    }
+
+    unmapFaultLog(faultLog, original);                  // Show the original page numbers
+
+    printTable(refs,                                    // Reference array
+               refCount,                                // Number of refs from the input line
+               frameCount,                              // Frame count
+               faultLog,                                // The fault log for displaying
+               pageFaults);                             // Number of page faults
+
+    return 0;
+}
+
+/**
+ * @brief Runs every scenario line of a text input
+ *
+ * Scenarios are labelled with printScenarioHeader() when the input holds
+ * more than one, so a single-line input prints exactly as before. Each
+ * scenario's pagers and scratch live in one RunArena (see arena.h), reset
+ * after it, and the parsed trace reuses the same buffers, so a long input
+ * does not go back to the global allocator scenario after scenario.
+ *
+ * @param filename The input file, or "-" for standard input
+ * @param options The command line options
+ *
+ * @return 0 if every scenario ran, 1 otherwise
+ */
+
+int runScenarios(const char *filename,
+                 const RunOptions &options)
+{
+    ScenarioReader reader(filename);                    // Reads one line at a time
+
+    if (!reader.more()) {                               // No scenario lines at all
+        std::cerr << "Input file is empty.\n";          // Print error message
+        return 1;                                       // Return 1
+    }                                                   // End if statement
+
+    bool multi = false;                                 // Whether the input has several scenarios
+    int status = 0;                                     // Exit status
+    std::string line;                                   // The current scenario line
+    int lineNumber;                                     // Where it came from
+    Trace trace;                                        // The current scenario's trace
+    RunArena arena;                                     // Per-run state, emptied after each scenario
+
+    for (int scenario = 1; reader.next(line, lineNumber); scenario++) {
+        if (scenario == 1 &&                            // A raw trace is analyzed as one whole
+            options.mode == MODE_ANALYZE && isRawTraceLine(line)) {
+            {
+                PAGER_PHASE(PHASE_PARSE);               // Time the parsing on its own
+                do {
+                    parseReferencesParallel(line, 0, trace.storage, options.threadCount);
+                } while (reader.next(line, lineNumber));
+            }
+            trace.useStorage();
+            return runScenario(trace, options);
+        }
+
+        if (scenario == 1)                              // Decide on labels after the first line
+            multi = reader.more();
+        if (multi && options.format == FORMAT_TEXT)     // Labels would break CSV and JSON
+            printScenarioHeader(scenario, lineNumber);
+
+        {
+            ArenaScope scope(arena);                    // The scenario's scratch comes from arena
+            parseInputLineParallel(line,                // Parse the input line
+                                   trace.algo,          // Algorithm to be used
+                                   trace.frameCount,    // Frame count that can be used
+                                   trace.storage,       // Reference array
+                                   options.threadCount); // Long lines are split across threads
+            trace.useStorage();
+
+            if (options.mode == MODE_COST) {            // Only the cost model reads write flags
+                char algo;
+                int frameCount;
+                trace.writes.clear();
+                parseWriteFlags(line, parseHeader(line, algo, frameCount), trace.writes);
+            }
+
+            if (runScenario(trace, options) != 0)       // Keep going after a bad scenario
+                status = 1;
+        }
+        arena.reset();
+    }
+
+    return status;
+}
 
 /**
  * @brief Main function
  */
 
 int main(int argc, char *argv[]) {                      // Main function
-    
-    if (argc != 2) {                                    // If the number of arguments is not equal to 2
+
+    PAGER_REPORT();                                     // Instrumented builds report on exit
+
+    RunOptions options = {MODE_TABLE, nullptr, nullptr, 0, 0.01, 8192, false, 65536,
+                          nullptr, 10000000, false, nullptr, false, 0, {1, 100, 100}, 0,
+                          nullptr, -1, -1, 0, FORMAT_TEXT};
+    int modeFlags = 0;                                  // Number of mode flags given
+    const char *inputFile = nullptr;                    // The input file name ("-" = stdin)
+    bool badArgs = false;                               // Set when an argument is not understood
+
+    const char *serveSocket = nullptr;                  // Serve: socket file to listen on
+    const char *pffSpec = nullptr;                      // Variable: PFF thresholds as given
+    const char *convertFile = nullptr;                  // Convert: binary trace to write
+    TraceEncoding encoding = ENCODING_FIXED;            // Convert: how to store the references
+    const char *value;                                  // Value of a --name=value option
+
+    for (int i = 1; i < argc; i++) {                    // Walk the command line arguments
+        if (std::strcmp(argv[i], "--stream") == 0)      // Streaming mode flag
+            options.mode = MODE_STREAM, modeFlags++;
+        else if ((value = optionValue(argv[i], "--window=")))
+            options.window = std::atoi(value);
+        else if ((value = optionValue(argv[i], "--checkpoint=")))
+            options.checkpointFile = value;
+        else if ((value = optionValue(argv[i], "--checkpoint-every=")))
+            options.checkpointEvery = std::atoll(value);
+        else if (std::strcmp(argv[i], "--resume") == 0)
+            options.resume = true;
+        else if (std::strcmp(argv[i], "--curve") == 0)  // Fault curve mode flag
+            options.mode = MODE_CURVE, modeFlags++;
+        else if (std::strcmp(argv[i], "--shards") == 0) // Sampled fault curve mode flag
+            options.mode = MODE_SHARDS, modeFlags++;
+        else if (std::strcmp(argv[i], "--analyze") == 0) // Trace analysis mode flag
+            options.mode = MODE_ANALYZE, modeFlags++;
+        else if ((value = optionValue(argv[i], "--hierarchy=")))
+            options.tierSpec = value, options.mode = MODE_HIERARCHY, modeFlags++;
+        else if (std::strcmp(argv[i], "--inclusive") == 0)
+            options.exclusive = false;
+        else if (std::strcmp(argv[i], "--exclusive") == 0)
+            options.exclusive = true;
+        else if ((value = optionValue(argv[i], "--memory-latency=")))
+            options.memoryLatency = std::atof(value);
+        else if (std::strcmp(argv[i], "--cost") == 0)   // Cost model mode flag
+            options.mode = MODE_COST, modeFlags++;
+        else if ((value = optionValue(argv[i], "--hit-cost=")))
+            options.costs.hit = std::atof(value);
+        else if ((value = optionValue(argv[i], "--fault-cost=")))
+            options.costs.fault = std::atof(value);
+        else if ((value = optionValue(argv[i], "--writeback-cost=")))
+            options.costs.writeBack = std::atof(value);
+        else if ((value = optionValue(argv[i], "--clean-window=")))
+            options.cleanWindow = std::atoi(value);
+        else if ((value = optionValue(argv[i], "--working-set=")))
+            options.tauSpec = value;
+        else if ((value = optionValue(argv[i], "--pff=")))
+            pffSpec = value;
+        else if ((value = optionValue(argv[i], "--interval=")))
+            options.interval = std::atoi(value);
+        else if ((value = optionValue(argv[i], "--rate=")))
+            options.sampleRate = std::atof(value);
+        else if ((value = optionValue(argv[i], "--max-samples=")))
+            options.maxSamples = std::atoi(value);
+        else if (std::strcmp(argv[i], "--verify") == 0)
+            options.verify = true;
+        else if (std::strcmp(argv[i], "--summary") == 0) // Summary mode flag
+            options.mode = MODE_SUMMARY, modeFlags++;
+        else if (std::strcmp(argv[i], "--format=text") == 0)
+            options.format = FORMAT_TEXT;
+        else if (std::strcmp(argv[i], "--format=csv") == 0)
+            options.format = FORMAT_CSV;
+        else if (std::strcmp(argv[i], "--format=json") == 0)
+            options.format = FORMAT_JSON;
+        else if (std::strcmp(argv[i], "--batch") == 0)  // Batch mode flag
+            options.mode = MODE_BATCH, modeFlags++;
+        else if ((value = optionValue(argv[i], "--policies=")))
+            options.policies = value;
+        else if ((value = optionValue(argv[i], "--frames=")))
+            options.frameSpec = value;
+        else if ((value = optionValue(argv[i], "--threads=")))
+            options.threadCount = std::atoi(value);
+        else if ((value = optionValue(argv[i], "--serve=")))
+            serveSocket = value, options.mode = MODE_SERVE, modeFlags++;
+        else if ((value = optionValue(argv[i], "--convert=")))
+            convertFile = value, options.mode = MODE_CONVERT, modeFlags++;
+        else if (std::strcmp(argv[i], "--encoding=fixed") == 0)
+            encoding = ENCODING_FIXED;
+        else if (std::strcmp(argv[i], "--encoding=varint") == 0)
+            encoding = ENCODING_VARINT;
+        else if (!inputFile && (argv[i][0] != '-' ||    // First plain argument is the input file
+                                std::strcmp(argv[i], "-") == 0))
+            inputFile = argv[i];
+        else
+            badArgs = true;                             // Anything else is a usage error
+    }
+
+    if (options.tauSpec || pffSpec)                     // Either or both select variable allocation
+        options.mode = MODE_VARIABLE, modeFlags++;
+    if (pffSpec && !parsePffThresholds(pffSpec, options.pffLower, options.pffUpper))
+        badArgs = true;                                 // Thresholds malformed or out of range
+    if (options.interval < 0)
+        badArgs = true;                                 // Timeline spacing out of range
+
+    if (options.format != FORMAT_TEXT && modeFlags == 0) // A result format implies summary mode
+        options.mode = MODE_SUMMARY;
+    if (options.format != FORMAT_TEXT && options.mode != MODE_SUMMARY)
+        badArgs = true;                                 // Only summaries have formats
+
+    if (!(options.sampleRate > 0 && options.sampleRate <= 1) || options.maxSamples < 1)
+        badArgs = true;                                 // SHARDS settings out of range
+    if (options.window < 0)
+        badArgs = true;                                 // Look-ahead out of range
+    if (!(options.memoryLatency >= 0))
+        badArgs = true;                                 // Latency out of range
+    if (!(options.costs.hit >= 0 && options.costs.fault >= 0 &&
+          options.costs.writeBack >= 0) || options.cleanWindow < 0)
+        badArgs = true;                                 // Costs out of range
+    if (options.checkpointFile && options.mode != MODE_STREAM)
+        badArgs = true;                                 // Only streamed runs are checkpointed
+    if ((options.resume && !options.checkpointFile) || options.checkpointEvery < 1)
+        badArgs = true;                                 // Nothing to resume from
+
+    if ((options.mode == MODE_SERVE) == (inputFile != nullptr))
+        badArgs = true;                                 // The server takes its traces from requests
+
+    if (badArgs || modeFlags > 1) {                     // If the arguments are not usable
         std::cerr << "Usage: " <<                       // Throw an error message
-            argv[0] << " <input_file>\n";               // Display the usage message
+            argv[0] << " [--curve] <input_file>\n" <<
+            "       " << argv[0] << " --stream [--window=65536] [--checkpoint=<file>" <<
+            " [--checkpoint-every=N] [--resume]] <input_file>\n" <<
+            "       " << argv[0] << " --summary [--format=text|csv|json] <input_file>\n" <<
+            "       " << argv[0] << " --shards [--rate=0.01] [--max-samples=8192] [--verify]" <<
+            " <input_file>\n" <<
+            "       " << argv[0] << " --analyze <input_file>\n" <<
+            "       " << argv[0] << " --hierarchy=L4,L64[@latency,...] [--exclusive]" <<
+            " [--memory-latency=X] <input_file>\n" <<
+            "       " << argv[0] << " --cost [--hit-cost=1] [--fault-cost=100]" <<
+            " [--writeback-cost=100] [--clean-window=N] <input_file>\n" <<
+            "       " << argv[0] << " --working-set=TAU[,TAU...] [--pff=LOWER,UPPER]" <<
+            " [--interval=N] <input_file>\n" <<
+            "       " << argv[0] << " --pff=LOWER,UPPER [--interval=N] <input_file>\n" <<
+            "       " << argv[0] << " --serve=<socket> [--threads=N]\n" <<
+            "       " << argv[0] << " --batch [--policies=FLO] [--frames=1-64]" <<
+            " [--threads=N] <input_file>\n" <<
+            "       " << argv[0] << " --convert=<binary_file> [--encoding=fixed|varint]" <<
+            " <input_file>\n" <<
+            "Use - as the input file to read standard input.\n";
 
         return 1;                                       // Return 1
     }                                                   // End if statement
 
-    std::string line = readLineFromFile(argv[1]);       // Run readLineFromFile function using argv[1] as an argument
-    
-    int frameCount, refCount;                           // Declare frame count and reference count variables
-    char algo;                                          // Declare algorithm variable
-    int refs[100];                                      // Declare reference count array
+    if (options.mode == MODE_STREAM) {                  // Streaming mode never loads the whole trace
+        if (!options.checkpointFile)
+            return runStream(inputFile, options.window, nullptr, false);
 
-    int displayTable[50][1000];
+        Checkpoint checkpoint(options.checkpointFile, options.checkpointEvery);
+        return runStream(inputFile, options.window, &checkpoint, options.resume);
+    }
 
-    parseInputLine(line,                                // Parse the input line
-                   algo,                                // Algorithm to be used
-                   frameCount,                          // Frame count that can be used
-                   refs,                                // Reference count array
-                   refCount);                           // Number of references from the input line
+    if (options.mode == MODE_SERVE) {                   // Answer requests until told to stop
+        SimulationServer server(options.threadCount);
+        if (!server.run(serveSocket)) {
+            std::cerr << "Cannot serve on " << serveSocket << ".\n";
+            return 1;
+        }
+        return 0;
+    }
 
-    wipeTable(displayTable, frameCount, refCount);      // Wipe display table
+    if (options.mode == MODE_CONVERT) {                 // Conversion rewrites the first scenario
+        Trace trace;
+        loadTrace(inputFile, trace);
+        return runConvert(trace, convertFile, encoding);
+    }
 
-    int pageFaults;                                     // Declare number of page faults
+    if (options.mode == MODE_SUMMARY &&                 // CSV summaries share one header
+        options.format == FORMAT_CSV)
+        std::cout << "Algorithm,Frames,References,Faults,HitRatio,Seconds\n";
 
-    switch (algo)                                       // Start switch statement
-    {
-        case 'F': case 'f':                             // If file contains f or F
-            pageFaults = FIFO(frameCount,               // Run FIFO with frameCount
-                              refs,                     // Reference array
-                              refCount,                 // Number of refs from the input line
-                              displayTable);            // The table for displaying
-            break;                                      // Break out of switch statement
-
-        case 'O': case 'o':                             // If file contains o or O
-            pageFaults = OPT(frameCount,                // Run OPT with frameCount
-                             refs,                      // Reference array
-                             refCount,                  // Number of refs from the input line
-                             displayTable);             // The table for displaying
-            break;                                      // Break out of switch statement
-
-        case 'L': case 'l':                             // If file contains l or L
-            pageFaults = LRU(frameCount,                // Run LRU with frameCount
-                             refs,                      // Reference array
-                             refCount,                  // Number of refs from the input line
-                             displayTable);             // The table for displaying
-            break;                                      // Break out of switch statement
+    if (isBinaryTrace(inputFile)) {                     // A binary trace holds a single scenario
+        Trace trace;
+        loadBinaryTrace(inputFile, trace);
+        return runScenario(trace, options);
     }
 
-    printTable(refs,                                    // Reference array
-               refCount,                                // Number of refs from the input line
-               frameCount,                              // Frame count
-               displayTable,                            // The table for displaying
-               pageFaults);                             // Number of page faults
-    
-}                                                       // End main statement
\ No newline at end of file
+    return runScenarios(inputFile, options);            // Run every line of a text input
+}                                                       // End main statement
@@ -0,0 +1,115 @@
+/**
+ * Miss-ratio curves
+ *
+ * Mattson's LRU stack algorithm: one pass over the trace gives the LRU
+ * page-fault count for every frame count at once.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_MRC_H
+#define PAGER_MRC_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "instrument.h"
+
+/**
+ * @brief Binary indexed (Fenwick) tree over counts, for prefix sums in
+ *        O(log n).
+ */
+
+class FenwickTree {
+public:
+    explicit FenwickTree(int size) : tree(size + 1, 0) {}
+
+    /**
+     * @brief Add delta to the count at position i (0-based).
+     */
+
+    void add(int i, int delta)
+    {
+        for (i++; i < (int)tree.size(); i += i & -i)
+            tree[i] += delta;
+    }
+
+    /**
+     * @brief Sum of the counts at positions [0, i).
+     */
+
+    int prefix(int i) const
+    {
+        int sum = 0;
+        for (; i > 0; i -= i & -i)
+            sum += tree[i];
+        return sum;
+    }
+
+private:
+    std::vector<int> tree;
+};
+
+/**
+ * @brief Compute LRU page faults for every frame count from 1 to maxFrames.
+ *
+ * The stack distance of a reference is the number of distinct pages used
+ * since the previous reference to the same page, itself included. LRU
+ * with c frames faults exactly on references whose distance is above c,
+ * plus the first reference to each page. The distinct-page count comes
+ * from a Fenwick tree that marks the latest reference to every page, so
+ * the whole curve costs O(n log n).
+ *
+ * @param refs[]    Array of page references from the input
+ * @param refCount  Number of page references in the input
+ * @param maxFrames Largest frame count to report
+ *
+ * @return faults[c] for c = 1..maxFrames (faults[0] is unused)
+ */
+
+inline std::vector<long long> stackDistanceFaults(const int refs[],
+                                                  int refCount,
+                                                  int maxFrames)
+{
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    FenwickTree latest(refCount);                   // 1 at the latest reference to each page
+    std::unordered_map<int, int> lastSeen;          // Page -> index of its latest reference
+
+    // hist[d] = references with stack distance d; distances past maxFrames
+    // fault for every size we report, so they share the last bucket
+    std::vector<long long> hist(maxFrames + 2, 0);
+    long long coldMisses = 0;
+
+    for (int t = 0; t < refCount; t++) {
+        std::unordered_map<int, int>::iterator it = lastSeen.find(refs[t]);
+
+        if (it == lastSeen.end()) {
+            coldMisses++;
+            lastSeen[refs[t]] = t;
+        }
+        else {
+            int prev = it->second;
+            int distance = latest.prefix(t) - latest.prefix(prev + 1) + 1;
+            hist[distance <= maxFrames ? distance : maxFrames + 1]++;
+
+            latest.add(prev, -1);
+            it->second = t;
+        }
+
+        latest.add(t, 1);
+    }
+
+    // faults[c] = cold misses + references with distance above c
+    std::vector<long long> faults(maxFrames + 1, 0);
+    long long farther = hist[maxFrames + 1];
+    for (int c = maxFrames; c >= 1; c--) {
+        faults[c] = coldMisses + farther;
+        farther += hist[c];
+    }
+
+    return faults;
+}
+
+#endif
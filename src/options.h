@@ -0,0 +1,79 @@
+/**
+ * Command line helpers
+ *
+ * Small parsers shared by the pager and benchmark command lines.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_OPTIONS_H
+#define PAGER_OPTIONS_H
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Match a "--name=value" argument
+ *
+ * @param arg The command line argument
+ * @param name The option name including the leading dashes and '='
+ *
+ * @return The value part, or nullptr if arg is a different option
+ */
+
+inline const char *optionValue(const char *arg,
+                               const char *name)
+{
+    size_t len = std::strlen(name);
+    return std::strncmp(arg, name, len) == 0 ? arg + len : nullptr;
+}
+
+/**
+ * @brief Parse a frame-count list such as "1-8,16,32".
+ *
+ * @param spec The list: comma-separated counts or inclusive ranges
+ * @param frameCounts Receives the counts in the order given
+ *
+ * @return false if the list is malformed or contains a count below 1
+ */
+
+inline bool parseFrameList(const std::string &spec,
+                           std::vector<int> &frameCounts)
+{
+    frameCounts.clear();
+
+    size_t i = 0;
+    while (i < spec.size()) {
+        int low = 0, high = 0;
+        size_t start = i;
+
+        while (i < spec.size() && spec[i] >= '0' && spec[i] <= '9')
+            low = low * 10 + (spec[i++] - '0');
+        if (i == start)
+            return false;
+
+        high = low;
+        if (i < spec.size() && spec[i] == '-') {
+            start = ++i;
+            high = 0;
+            while (i < spec.size() && spec[i] >= '0' && spec[i] <= '9')
+                high = high * 10 + (spec[i++] - '0');
+            if (i == start)
+                return false;
+        }
+
+        if (low < 1 || high < low)
+            return false;
+        for (int f = low; f <= high; f++)
+            frameCounts.push_back(f);
+
+        if (i < spec.size() && spec[i++] != ',')
+            return false;
+    }
+
+    return !frameCounts.empty();
+}
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * Buffered output
+ *
+ * Large tables are written through one reusable buffer instead of an
+ * iostream call per cell. Integers are formatted by hand, so no locale or
+ * stream state is consulted.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_OUTPUT_H
+#define PAGER_OUTPUT_H
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "arena.h"
+
+/**
+ * @brief Number of characters needed to print value in decimal.
+ */
+
+inline int decimalWidth(long long value)
+{
+    int width = value < 0 ? 2 : 1;
+    unsigned long long magnitude = value < 0 ? -(unsigned long long)value : value;
+    while (magnitude >= 10) {
+        magnitude /= 10;
+        width++;
+    }
+    return width;
+}
+
+/**
+ * @brief A character buffer written to stdout in large blocks.
+ *
+ * Callers reserve() room for the next chunk of output, append to it
+ * without bounds checks, and the buffer is flushed whenever a reservation
+ * would not fit. Output goes through stdio, which std::cout is
+ * synchronised with, so it interleaves correctly with std::cout.
+ */
+
+class OutputBuffer {
+public:
+    /**
+     * @param capacity Initial buffer size in bytes
+     */
+
+    explicit OutputBuffer(size_t capacity)
+        : data(capacity), used(0) {}
+
+    ~OutputBuffer()
+    {
+        flush();
+    }
+
+    /**
+     * @brief Make room for at least bytes more characters.
+     */
+
+    void reserve(size_t bytes)
+    {
+        if (used + bytes <= data.size())
+            return;
+        flush();
+        if (bytes > data.size())
+            data.resize(bytes);
+    }
+
+    void put(char c)
+    {
+        data[used++] = c;
+    }
+
+    void put(const char *text)
+    {
+        size_t length = std::strlen(text);
+        std::memcpy(&data[used], text, length);
+        used += length;
+    }
+
+    /**
+     * @brief Append an integer in decimal.
+     */
+
+    void putInt(long long value)
+    {
+        unsigned long long magnitude = value;
+        if (value < 0) {
+            data[used++] = '-';
+            magnitude = -(unsigned long long)value;
+        }
+
+        char digits[20];
+        int count = 0;
+        do {
+            digits[count++] = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude);
+
+        while (count)
+            data[used++] = digits[--count];
+    }
+
+    /**
+     * @brief Append the same character count times.
+     */
+
+    void fill(char c, size_t count)
+    {
+        std::memset(&data[used], c, count);
+        used += count;
+    }
+
+    /**
+     * @brief Write out everything buffered so far.
+     */
+
+    void flush()
+    {
+        if (used)
+            std::fwrite(data.data(), 1, used, stdout);
+        used = 0;
+    }
+
+private:
+    RunVector<char> data;       // Buffered characters
+    size_t used;                // Number of characters in data
+};
+
+#endif
@@ -0,0 +1,307 @@
+/**
+ * Simulation driver
+ *
+ * Pager<Policy> is the one page-replacement loop every engine shares: it
+ * owns the frames, finds resident pages, fills empty frames and counts
+ * faults. What differs between algorithms is only which frame to give up,
+ * and that lives in a small policy class with four hooks (onRemove only
+ * for callers that remove pages):
+ *
+ *   void onHit(int slot, long long t)             page in slot was referenced
+ *   int  chooseVictim(int page, long long t)      pick the frame to replace
+ *   void onMiss(int slot, int page, long long t)  page was loaded into slot
+ *   void onRemove(int slot)                       page in slot was removed
+ *
+ * t is the index of the reference. Callers that take pages out without
+ * replacing them (see hierarchy.h) need onRemove(); others never call it.
+ * The policy is a template argument, so each Pager<> instantiation
+ * compiles to its own loop with the hooks inlined; there are no virtual
+ * calls per reference.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_PAGER_H
+#define PAGER_PAGER_H
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "findpage.h"
+#include "instrument.h"
+
+/**
+ * @brief Empty hooks, for policies that do not care about some events.
+ */
+
+struct PolicyBase {
+    void onHit(int, long long) {}
+    void onMiss(int, int, long long) {}
+};
+
+/**
+ * @brief Maps resident pages to their frames.
+ *
+ * Small memories are searched directly with findPage(), which beats any
+ * hash lookup while the frames fit in a few cache lines. Above
+ * FRAME_SCAN_LIMIT frames a hash index keeps lookups O(1). The choice is
+ * made once per run; the branch on it is perfectly predictable.
+ */
+
+const int FRAME_SCAN_LIMIT = 512;
+
+class FrameIndex {
+public:
+    explicit FrameIndex(int frameCount)
+        : hashed(frameCount > FRAME_SCAN_LIMIT)
+    {
+        if (hashed)
+            slotOf.reserve(frameCount);
+    }
+
+    /**
+     * @return The frame holding page, or -1 if it is not resident
+     */
+
+    int find(const RunVector<int> &frames, int page) const
+    {
+        if (!hashed) {
+            int slot = findPage(frames.data(), frames.size(), page);
+            PAGER_PROBE(slot == -1 ? (int)frames.size() : slot + 1);
+            return slot;
+        }
+
+        PAGER_PROBE(slotOf.bucket_size(slotOf.bucket(page)));
+        RunHashMap<int, int>::const_iterator it = slotOf.find(page);
+        return it == slotOf.end() ? -1 : it->second;
+    }
+
+    void insert(int page, int slot)
+    {
+        if (hashed)
+            slotOf[page] = slot;
+    }
+
+    void erase(int page)
+    {
+        if (hashed)
+            slotOf.erase(page);
+    }
+
+private:
+    bool hashed;                            // Use slotOf instead of scanning
+    RunHashMap<int, int> slotOf;            // Resident page -> frame holding it
+};
+
+/**
+ * @brief Residency index for dense page numbers: residentSlot[page] is the
+ *        frame holding page, or -1.
+ *
+ * The table grows to the largest page seen, which for a remapped trace is
+ * the number of distinct pages (see remapTrace()).
+ */
+
+class DenseIndex {
+public:
+    explicit DenseIndex(int) {}
+
+    int find(const RunVector<int> &, int page) const
+    {
+        PAGER_PROBE(1);
+        return (size_t)page < residentSlot.size() ? residentSlot[page] : -1;
+    }
+
+    void insert(int page, int slot)
+    {
+        if ((size_t)page >= residentSlot.size())
+            residentSlot.resize(page + page / 2 + 1, -1);
+        residentSlot[page] = slot;
+    }
+
+    void erase(int page)
+    {
+        residentSlot[page] = -1;
+    }
+
+private:
+    RunVector<int> residentSlot;    // Page -> frame holding it (-1 = not resident)
+};
+
+/**
+ * @brief Replacement state fed one page reference at a time.
+ *
+ * Frames are filled in order. Only once memory is full is the policy
+ * asked for a victim, unless remove() has freed a frame, which is then
+ * reused first.
+ *
+ * @tparam Policy Replacement policy (see the file comment for its hooks)
+ * @tparam Index  Residency index: FrameIndex, or DenseIndex for a trace
+ *                remapped by remapTrace()
+ */
+
+template <class Policy, class Index = FrameIndex>
+class Pager {
+public:
+    RunVector<int> frames;      // The memory frames currently holding pages
+    Policy policy;              // Replacement decisions
+    Index index;                // Resident page -> frame
+    int loaded;                 // Number of frames filled so far
+    long long time;             // Index of the next reference
+    long long pageFaults;       // Count how many misses occur
+    int faultSlot;              // Frame loaded by the latest fault
+    int evictedPage;            // Page replaced by the latest fault (-1 = none)
+    RunVector<int> freeSlots;   // Frames emptied by remove()
+
+    /**
+     * @param frameCount Number of frames that can be used
+     * @param args       Passed on to the policy after frameCount
+     */
+
+    template <class... Args>
+    explicit Pager(int frameCount, Args &&... args)
+        : frames(frameCount, -1), policy(frameCount, std::forward<Args>(args)...),
+          index(frameCount), loaded(0), time(0), pageFaults(0),
+          faultSlot(-1), evictedPage(-1) {}
+
+    /**
+     * @brief Reference one page.
+     *
+     * @param page The requested page
+     *
+     * @return true if the reference caused a page fault
+     */
+
+    bool access(int page)
+    {
+        return access(page, time++);
+    }
+
+    /**
+     * @brief Reference one page, telling the policy it is reference t.
+     *
+     * For callers that keep their own clock; time is not advanced.
+     *
+     * @param page The requested page
+     * @param t    Index of the reference the hooks should see
+     *
+     * @return true if the reference caused a page fault
+     */
+
+    bool access(int page, long long t)
+    {
+        PAGER_COUNT(lookups, 1);
+        int slot = index.find(frames, page);
+        if (slot != -1) {
+            PAGER_COUNT(hits, 1);
+            policy.onHit(slot, t);
+            return false;
+        }
+
+        pageFaults++;
+
+        if (loaded < (int)frames.size()) {
+            slot = loaded++;
+        }
+        else if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = policy.chooseVictim(page, t);
+            index.erase(frames[slot]);
+            PAGER_COUNT(evictions, 1);
+        }
+
+        faultSlot = slot;
+        evictedPage = frames[slot];
+        frames[slot] = page;
+        index.insert(page, slot);
+        policy.onMiss(slot, page, t);
+
+        return true;
+    }
+
+    /**
+     * @brief Whether page is resident.
+     */
+
+    bool contains(int page) const
+    {
+        return index.find(frames, page) != -1;
+    }
+
+    /**
+     * @brief Take a page out of memory without loading another.
+     *
+     * Its frame is free until the next fault. Needs a policy with
+     * onRemove().
+     *
+     * @return false if page was not resident
+     */
+
+    bool remove(int page)
+    {
+        int slot = index.find(frames, page);
+        if (slot == -1)
+            return false;
+
+        index.erase(page);
+        frames[slot] = -1;
+        freeSlots.push_back(slot);
+        policy.onRemove(slot);
+        return true;
+    }
+
+    /**
+     * @brief Append the replacement state to out (see checkpoint.h).
+     *
+     * Only available when the policy has saveState(). The residency index
+     * is not saved; loadState() rebuilds it from the frames.
+     */
+
+    template <class Out>
+    void saveState(Out &out) const
+    {
+        out.put(loaded);
+        out.put(time);
+        out.put(pageFaults);
+        out.put(frames);
+        out.put((int)freeSlots.size());
+        out.put(freeSlots);
+        policy.saveState(out);
+    }
+
+    /**
+     * @brief Restore what saveState() wrote into a pager built with the
+     *        same frame count.
+     *
+     * @return false if in ran out or holds frame numbers out of range
+     */
+
+    template <class In>
+    bool loadState(In &in)
+    {
+        int freeCount;
+        if (!in.get(loaded) || !in.get(time) || !in.get(pageFaults) || !in.get(frames) ||
+            loaded < 0 || loaded > (int)frames.size() ||
+            !in.get(freeCount) || freeCount < 0 || freeCount > (int)frames.size())
+            return false;
+        freeSlots.resize(freeCount);
+        if (!in.get(freeSlots) || !policy.loadState(in))
+            return false;
+        for (size_t i = 0; i < freeSlots.size(); i++)
+            if (freeSlots[i] < 0 || freeSlots[i] >= (int)frames.size())
+                return false;
+
+        index = Index(frames.size());
+        for (int slot = 0; slot < loaded; slot++)
+            if (frames[slot] != -1)
+                index.insert(frames[slot], slot);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,240 @@
+/**
+ * Parallel trace parsing
+ *
+ * Long reference strings are split into chunks at separator boundaries
+ * and tokenized on several threads, eight digits at a time (SWAR), into
+ * one contiguous array. The result is identical to
+ * parseInputLine(): the header is parsed by the same code, any non-digit
+ * separates numbers, and values wrap modulo 2^32, as the serial loop's
+ * unsigned arithmetic does.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_PARSE_H
+#define PAGER_PARSE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "instrument.h"
+#include "trace.h"
+
+const size_t PARSE_CHUNK_BYTES = 1 << 20;  // Least text worth a thread of its own
+
+/**
+ * @brief Bytes of w that are not ASCII digits, as a nonzero byte each.
+ */
+
+inline std::uint64_t nonDigitBytes(std::uint64_t w)
+{
+    // High nibble must be 3 and low nibble at most 9; adding 6 to the low
+    // nibbles alone cannot carry into the next byte
+    return ((w & 0xF0F0F0F0F0F0F0F0ull) ^ 0x3030303030303030ull) |
+           (((w & 0x0F0F0F0F0F0F0F0Full) + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull);
+}
+
+/**
+ * @brief Value of the first count (1..8) digits of w, first digit in the
+ *        lowest byte.
+ */
+
+inline std::uint32_t swarDigits(std::uint64_t w,
+                                int count)
+{
+    // Move the digits to the top bytes; the zeros shifted in below them
+    // read as leading zeros
+    std::uint64_t d = (w - 0x3030303030303030ull) << (8 * (8 - count));
+    d = (d * 10 + (d >> 8)) & 0x00FF00FF00FF00FFull;
+    d = (d * 100 + (d >> 16)) & 0x0000FFFF0000FFFFull;
+    d = (d * 10000 + (d >> 32)) & 0xFFFFFFFFull;
+    return d;
+}
+
+/**
+ * @brief Number of numbers in [p, end), which must not start or end
+ *        inside a number.
+ */
+
+inline size_t countReferences(const char *p,
+                              const char *end)
+{
+    const std::uint64_t high = 0x8080808080808080ull;
+
+    size_t count = 0;
+    std::uint64_t before = high;    // High bit set: the byte before is not a digit
+
+    // A number starts at each digit whose preceding byte is not a digit
+    for (; end - p >= 8; p += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        std::uint64_t stop = nonDigitBytes(w);
+        stop = (((stop & ~high) + ~high) | stop) & high;    // High bit of each non-digit byte
+        count += __builtin_popcountll(~stop & high & ((stop << 8) | (before >> 56)));
+        before = stop;
+    }
+
+    bool inNumber = !(before >> 63);
+    for (; p < end; p++) {
+        bool digit = *p >= '0' && *p <= '9';
+        count += digit & !inNumber;
+        inNumber = digit;
+    }
+    return count;
+}
+
+/**
+ * @brief Store every number in [p, end) at out, in order.
+ *
+ * end must not fall inside a number. Up to 8 bytes past a number may be
+ * read, but never at or past limit (the end of the whole buffer).
+ *
+ * @return One past the last number stored
+ */
+
+inline int *parseReferenceChunk(const char *p,
+                                const char *end,
+                                const char *limit,
+                                int *out)
+{
+    static const std::uint32_t powers[9] = {1, 10, 100, 1000, 10000, 100000,
+                                            1000000, 10000000, 100000000};
+
+    while (p < end) {
+        // Skip separators
+        while (p < end && (*p < '0' || *p > '9'))
+            p++;
+        if (p >= end)
+            break;
+
+        std::uint32_t val = 0;      // Unsigned, so long numbers wrap as in parseReferences()
+
+        // Eight bytes at a time while they fit in the buffer
+        while (limit - p >= 8) {
+            std::uint64_t w;
+            std::memcpy(&w, p, 8);
+            std::uint64_t stop = nonDigitBytes(w);
+            int count = stop ? __builtin_ctzll(stop) / 8 : 8;
+            if (count == 0)
+                break;
+            val = val * powers[count] + swarDigits(w, count);
+            p += count;
+            if (count < 8)
+                break;
+        }
+
+        // Near the end of the buffer, one digit at a time
+        while (p < end && *p >= '0' && *p <= '9')
+            val = val * 10 + (*p++ - '0');
+
+        *out++ = (int)val;
+    }
+
+    return out;
+}
+
+/**
+ * @brief Append the page numbers found in line from position i onwards,
+ *        using up to threadCount threads.
+ *
+ * Each thread counts the numbers in its chunk, refs is grown once to the
+ * total, and each thread then converts its chunk straight into its own
+ * stretch of refs, so the parts never need copying together.
+ *
+ * @param line        Text to parse
+ * @param i           Position to start at
+ * @param refs        Receives the page references
+ * @param threadCount Number of threads (0 = one per core)
+ * @param chunkBytes  Least text given to each thread
+ */
+
+inline void parseReferencesParallel(const std::string &line,
+                                    size_t i,
+                                    std::vector<int> &refs,
+                                    int threadCount,
+                                    size_t chunkBytes = PARSE_CHUNK_BYTES)
+{
+    const char *begin = line.data() + std::min(i, line.size());
+    const char *limit = line.data() + line.size();
+    size_t bytes = limit - begin;
+
+    if (bytes < 2 * chunkBytes)
+        threadCount = 1;
+    if (threadCount <= 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount <= 0)
+        threadCount = 1;
+    if ((size_t)threadCount > bytes / chunkBytes)
+        threadCount = std::max<size_t>(1, bytes / chunkBytes);
+
+    // Chunk boundaries, each moved forward past any digits so no number
+    // is split between two chunks
+    RunVector<const char *> bounds(threadCount + 1);
+    bounds[0] = begin;
+    bounds[threadCount] = limit;
+    for (int c = 1; c < threadCount; c++) {
+        const char *at = std::max(bounds[c - 1], begin + bytes / threadCount * c);
+        while (at < limit && *at >= '0' && *at <= '9')
+            at++;
+        bounds[c] = at;
+    }
+
+    RunVector<size_t> offsets(threadCount + 1, 0);      // Where each chunk's numbers go in refs
+    offsets[0] = refs.size();
+
+    // Run pass(c) for every chunk, on the calling thread and threadCount - 1 others
+    auto forEachChunk = [&](auto pass) {
+        std::vector<std::thread> threads;
+        for (int c = 1; c < threadCount; c++)
+            threads.push_back(std::thread([&, c]() {
+                PAGER_PHASE(PHASE_PARSE);
+                pass(c);
+            }));
+        pass(0);
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+    };
+
+    forEachChunk([&](int c) {
+        offsets[c + 1] = countReferences(bounds[c], bounds[c + 1]);
+    });
+    for (int c = 0; c < threadCount; c++)
+        offsets[c + 1] += offsets[c];
+
+    refs.resize(offsets[threadCount]);
+    forEachChunk([&](int c) {
+        parseReferenceChunk(bounds[c], bounds[c + 1], limit, refs.data() + offsets[c]);
+    });
+}
+
+/**
+ * @brief parseInputLine() for long lines: same result, parsed on up to
+ *        threadCount threads.
+ *
+ * @param line The input line to parse.
+ * @param algo The selected algorithm.
+ * @param frameCount The number of frames in the cache.
+ * @param refs Vector that receives the reference values.
+ * @param threadCount Number of threads (0 = one per core)
+ */
+
+inline void parseInputLineParallel(const std::string &line,
+                                   char &algo,
+                                   int &frameCount,
+                                   std::vector<int> &refs,
+                                   int threadCount)
+{
+    PAGER_PHASE(PHASE_PARSE);
+
+    refs.clear();
+    size_t i = parseHeader(line, algo, frameCount);
+    parseReferencesParallel(line, i, refs, threadCount);
+}
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Dense page numbers
+ *
+ * Traces use arbitrary page numbers, but usually only a few distinct ones.
+ * remapTrace() renumbers the pages 0..U-1 in order of first use, so an
+ * engine can find a resident page with one indexed load (DenseIndex)
+ * instead of searching its frames. The original numbers are kept so output
+ * can be translated back.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_REMAP_H
+#define PAGER_REMAP_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "engines.h"
+
+/**
+ * @brief Renumber a trace's pages densely, in order of first use.
+ *
+ * @param refs[]   Array of page references
+ * @param refCount Number of page references
+ * @param dense    Receives the renumbered trace
+ * @param original Receives the original number of each dense page
+ *
+ * @return Number of distinct pages (U)
+ */
+
+template <class DenseAllocator, class OriginalAllocator>
+inline int remapTrace(const int refs[],
+                      int refCount,
+                      std::vector<int, DenseAllocator> &dense,
+                      std::vector<int, OriginalAllocator> &original)
+{
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    dense.resize(refCount);
+    original.clear();
+
+    int maxPage = 0;
+    bool negative = false;
+    for (int t = 0; t < refCount; t++) {
+        if (refs[t] > maxPage)
+            maxPage = refs[t];
+        negative |= refs[t] < 0;
+    }
+
+    if (!negative && maxPage < FLAT_PAGE_LIMIT && maxPage / 4 <= refCount) {
+        // Small page numbers: a flat table beats hashing
+        RunVector<int> idOf(maxPage + 1, -1);
+        for (int t = 0; t < refCount; t++) {
+            int &id = idOf[refs[t]];
+            if (id == -1) {
+                id = original.size();
+                original.push_back(refs[t]);
+            }
+            dense[t] = id;
+        }
+    }
+    else {
+        RunHashMap<int, int> idOf;
+        for (int t = 0; t < refCount; t++) {
+            std::pair<RunHashMap<int, int>::iterator, bool> slot =
+                idOf.insert(std::make_pair(refs[t], (int)original.size()));
+            if (slot.second)
+                original.push_back(refs[t]);
+            dense[t] = slot.first->second;
+        }
+    }
+
+    return original.size();
+}
+
+/**
+ * @brief Put the original page numbers back into a fault log recorded
+ *        over a remapped trace.
+ */
+
+template <class Allocator>
+inline void unmapFaultLog(FaultLog &log,
+                          const std::vector<int, Allocator> &original)
+{
+    for (size_t e = 0; e < log.size(); e++) {
+        log[e].loaded = original[log[e].loaded];
+        if (log[e].evicted != -1)
+            log[e].evicted = original[log[e].evicted];
+    }
+}
+
+#endif
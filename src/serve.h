@@ -0,0 +1,533 @@
+/**
+ * Simulation server
+ *
+ * Keeps parsed traces and warm pagers in memory and answers queries over
+ * a local Unix domain socket, so repeated questions about the same trace
+ * cost a simulation of only what changed. One request per line, one reply
+ * line each ("OK ..." or "ERR <message>"):
+ *
+ *   LOAD <name> <file>                       load the first scenario of a
+ *                                            text or binary trace
+ *                                            -> OK <references>
+ *   APPEND <name> <references>               append to a trace (a new name
+ *                                            starts an empty one)
+ *                                            -> OK <references> [<algo><frames>=<faults> ...]
+ *   FAULTS <name> <algo> <frames> [<a> <b>]  faults over references [a, b),
+ *                                            default the whole trace
+ *                                            -> OK <faults>
+ *   DROP <name>                              forget a trace -> OK
+ *   QUIT                                     close the connection
+ *   SHUTDOWN                                 -> OK, then the server exits
+ *
+ * A range starts with empty memory. FAULTS over [0, b) with any policy but
+ * OPT keeps its pager afterwards (up to WARM_PAGER_LIMIT per trace, the
+ * least recently queried going first); a later query at or past b continues
+ * from it, and APPEND runs every kept pager of the trace over the new
+ * references and reports the faults among them. Other queries are
+ * simulated from scratch. Pages are renumbered densely as they arrive, so
+ * every pager uses a DenseIndex.
+ *
+ * More frames than the trace has distinct pages change nothing, so a
+ * pager gets at most that many. A kept pager that was capped this way is
+ * dropped when APPEND brings in pages it has no room for; the next query
+ * rebuilds it. A request that fails for any other reason, including
+ * running out of memory, gets an ERR reply and the server carries on.
+ *
+ * Each client gets its own thread, so an idle connection holds nobody up.
+ * Requests from all clients are applied one at a time. SHUTDOWN's OK is
+ * sent before the server stops accepting and closes the other clients.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_SERVE_H
+#define PAGER_SERVE_H
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "bintrace.h"
+#include "engines.h"
+#include "hierarchy.h"
+#include "parse.h"
+#include "remap.h"
+#include "trace.h"
+
+const size_t WARM_PAGER_LIMIT = 32;     // Most pagers kept per trace
+
+/**
+ * @brief A trace held by the server, with its warm pagers.
+ */
+
+struct ServedTrace {
+    /**
+     * @brief A pager that has run over the first position references.
+     */
+
+    struct WarmPager {
+        std::unique_ptr<Tier> tier;     // The pager (see hierarchy.h)
+        int frameCount;                 // Frames it was built with (at most the distinct pages)
+        long long position;             // References simulated so far
+        long long pageFaults;           // Faults among them
+        long long lastQuery;            // When a FAULTS query last used it
+    };
+
+    std::vector<int> dense;                         // The references, renumbered 0..U-1
+    std::unordered_map<int, int> idOf;              // Original page -> dense page
+    std::map<std::pair<char, int>, WarmPager> warm; // (algorithm, frames) -> its pager
+    long long queries = 0;                          // FAULTS queries that used a warm pager
+
+    /**
+     * @brief Start from a whole trace, renumbered by remapTrace().
+     */
+
+    void assign(const int refs[],
+                int refCount)
+    {
+        std::vector<int> original;
+        remapTrace(refs, refCount, dense, original);
+        for (size_t page = 0; page < original.size(); page++)
+            idOf[original[page]] = page;
+    }
+
+    /**
+     * @brief Append references, renumbering new pages as they arrive.
+     */
+
+    void append(const int refs[],
+                int refCount)
+    {
+        for (int t = 0; t < refCount; t++) {
+            std::pair<std::unordered_map<int, int>::iterator, bool> slot =
+                idOf.insert(std::make_pair(refs[t], (int)idOf.size()));
+            dense.push_back(slot.first->second);
+        }
+    }
+
+    /**
+     * @brief Frames a pager needs to behave as if it had frameCount: no
+     *        more than the distinct pages seen so far, and at least one.
+     */
+
+    int framesFor(int frameCount) const
+    {
+        int universe = idOf.size();
+        return frameCount < universe ? frameCount : (universe > 0 ? universe : 1);
+    }
+
+    /**
+     * @brief Run a warm pager up to position end.
+     */
+
+    void advance(WarmPager &pager,
+                 long long end)
+    {
+        PAGER_PHASE(PHASE_SIMULATE);
+
+        for (long long t = pager.position; t < end; t++)
+            pager.pageFaults += pager.tier->access(dense[t], t);
+        pager.position = end;
+    }
+};
+
+/**
+ * @brief Answers requests about in-memory traces.
+ */
+
+class SimulationServer {
+public:
+    /**
+     * @param threadCount Threads for parsing long text traces (0 = one per core)
+     */
+
+    explicit SimulationServer(int threadCount)
+        : threadCount(threadCount), stopping(false), stopRequested(false), listening(-1) {}
+
+    /**
+     * @brief Serve clients on a Unix domain socket until SHUTDOWN.
+     *
+     * A socket file at path that no server is listening on is replaced;
+     * a live socket or any other file is left alone and the server does not
+     * start.
+     *
+     * @param path The socket file
+     *
+     * @return false if the socket could not be set up or failed
+     */
+
+    bool run(const char *path)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        if (std::strlen(path) >= sizeof address.sun_path)
+            return false;
+        std::strcpy(address.sun_path, path);
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0)
+            return false;
+
+        struct stat info;
+        if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+            if (connect(listener, reinterpret_cast<sockaddr *>(&address), sizeof address) == 0) {
+                close(listener);
+                return false;
+            }
+            unlink(path);
+        }
+        if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof address) != 0 ||
+            listen(listener, 16) != 0) {
+            close(listener);
+            return false;
+        }
+
+        listening = listener;
+        std::list<Connection> connections;      // Clients connected so far, some finished
+
+        while (!stopping) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;                          // Includes SHUTDOWN closing the listener
+            }
+
+            std::lock_guard<std::mutex> hold(connectionsLock);
+            reap(connections, false);
+            connections.push_back(Connection{std::thread(), client, false});
+            Connection &connection = connections.back();
+            connection.thread = std::thread([this, &connection]() {
+                serveClient(connection.socket);
+                std::lock_guard<std::mutex> hold(connectionsLock);
+                close(connection.socket);       // The client sees EOF now, not at the next accept
+                connection.done = true;
+            });
+        }
+
+        {
+            // Wake clients still waiting for requests, then wait for them;
+            // finished ones have closed their sockets already
+            std::lock_guard<std::mutex> hold(connectionsLock);
+            for (std::list<Connection>::iterator it = connections.begin(); it != connections.end(); ++it)
+                if (!it->done)
+                    shutdown(it->socket, SHUT_RDWR);
+        }
+        reap(connections, true);
+
+        close(listener);
+        unlink(path);
+        return stopping;
+    }
+
+    /**
+     * @brief Answer one request line.
+     *
+     * @param request The request, without its newline
+     * @param hangUp  Set when the connection should be closed
+     *
+     * @return The reply line, without its newline (empty for QUIT)
+     */
+
+    std::string handle(const std::string &request,
+                       bool &hangUp)
+    {
+        std::istringstream in(request);
+        std::string command, name;
+        in >> command >> name;
+
+        hangUp = false;
+        if (command == "QUIT") {
+            hangUp = true;
+            return "";
+        }
+        if (command == "SHUTDOWN") {
+            hangUp = stopRequested = true;      // serveClient() stops the server after replying
+            return "OK";
+        }
+        if (name.empty())
+            return "ERR missing trace name";
+
+        if (command == "LOAD") {
+            std::string file;
+            in >> file;
+            return file.empty() ? "ERR missing file name" : load(name, file);
+        }
+        if (command == "APPEND")
+            return append(name, request, in.tellg() < 0 ? request.size() : (size_t)in.tellg());
+        if (command == "DROP")
+            return traces.erase(name) ? "OK" : "ERR unknown trace";
+        if (command == "FAULTS")
+            return faults(name, in);
+
+        return "ERR unknown command";
+    }
+
+private:
+    std::unordered_map<std::string, ServedTrace> traces;   // Name -> trace
+    /**
+     * @brief A connected client and the thread serving it.
+     */
+
+    struct Connection {
+        std::thread thread;     // Runs serveClient()
+        int socket;             // The client's socket
+        bool done;              // The client has gone (guarded by connectionsLock)
+    };
+
+    int threadCount;                                        // Parsing threads
+    std::atomic<bool> stopping;                             // SHUTDOWN was answered
+    bool stopRequested;                                     // SHUTDOWN was handled (guarded by stateLock)
+    int listening;                                          // The listening socket
+    std::mutex stateLock;                                   // Held while a request runs
+    std::mutex connectionsLock;                             // Guards Connection::done and closing
+
+    /**
+     * @brief Join and forget finished connections, or all of them.
+     *
+     * Each connection's thread closes its own socket. Called with
+     * connectionsLock held unless all is set.
+     */
+
+    void reap(std::list<Connection> &connections,
+              bool all)
+    {
+        for (std::list<Connection>::iterator it = connections.begin(); it != connections.end(); ) {
+            if (!all && !it->done) {
+                ++it;
+                continue;
+            }
+            it->thread.join();
+            it = connections.erase(it);
+        }
+    }
+
+    /**
+     * @brief Read request lines from a client and write the replies until
+     *        it disconnects or asks to close.
+     */
+
+    void serveClient(int client)
+    {
+        std::string pending;        // Bytes received but not yet a whole line
+        size_t searched = 0;        // Bytes of pending known to hold no newline
+        char chunk[1 << 16];
+
+        for (;;) {
+            size_t newline;
+            while ((newline = pending.find('\n', searched)) != std::string::npos) {
+                std::string request = pending.substr(0, newline);
+                pending.erase(0, newline + 1);
+                searched = 0;
+                if (!request.empty() && request.back() == '\r')
+                    request.pop_back();
+                if (request.find_first_not_of(" \t") == std::string::npos)
+                    continue;
+
+                bool hangUp = false;
+                bool stop = false;
+                std::string reply;
+                try {
+                    std::lock_guard<std::mutex> hold(stateLock);
+                    reply = handle(request, hangUp);
+                    stop = stopRequested;
+                }
+                catch (const std::exception &error) {
+                    reply = std::string("ERR ") + error.what();
+                }
+                if (!reply.empty()) {
+                    reply += '\n';
+                    if (!sendAll(client, reply) && !stop)
+                        return;
+                }
+                if (stop) {
+                    stopping = true;
+                    shutdown(listening, SHUT_RDWR);     // Wakes the accept loop
+                }
+                if (hangUp)
+                    return;
+            }
+
+            ssize_t got = recv(client, chunk, sizeof chunk, 0);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                return;
+            searched = pending.size();
+            pending.append(chunk, got);
+        }
+    }
+
+    /**
+     * @brief Drop the warm pager queried least recently.
+     */
+
+    static void forgetOldest(ServedTrace &served)
+    {
+        std::map<std::pair<char, int>, ServedTrace::WarmPager>::iterator oldest = served.warm.begin();
+        for (std::map<std::pair<char, int>, ServedTrace::WarmPager>::iterator it = served.warm.begin();
+             it != served.warm.end(); ++it)
+            if (it->second.lastQuery < oldest->second.lastQuery)
+                oldest = it;
+        served.warm.erase(oldest);
+    }
+
+    /**
+     * @brief Parse a whole token as a number.
+     *
+     * @return false if text is empty or is not entirely a number
+     */
+
+    static bool parseCount(const std::string &text,
+                           long long &value)
+    {
+        char *rest;
+        errno = 0;
+        value = std::strtoll(text.c_str(), &rest, 10);
+        return !text.empty() && !*rest && errno == 0;
+    }
+
+    static bool sendAll(int client,
+                        const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            sent += n;
+        }
+        return true;
+    }
+
+    std::string load(const std::string &name,
+                     const std::string &file)
+    {
+        Trace trace;
+
+        if (isBinaryTrace(file.c_str())) {
+            const char *error = readBinaryTrace(file.c_str(), trace);
+            if (error)
+                return std::string("ERR ") + error;
+        }
+        else {
+            std::ifstream in(file.c_str());
+            if (!in)
+                return "ERR Cannot open input file.";
+
+            std::string line;
+            while (std::getline(in, line) && line.find_first_not_of(" \t\r") == std::string::npos)
+                ;
+            if (!in)
+                return "ERR Input file is empty.";
+
+            parseInputLineParallel(line, trace.algo, trace.frameCount, trace.storage, threadCount);
+            trace.useStorage();
+        }
+
+        ServedTrace &served = traces[name] = ServedTrace();
+        served.assign(trace.refs, trace.refCount);
+        return "OK " + std::to_string(served.dense.size());
+    }
+
+    std::string append(const std::string &name,
+                       const std::string &request,
+                       size_t at)
+    {
+        std::vector<int> refs;
+        parseReferences(request, at, refs);
+
+        ServedTrace &served = traces[name];
+        long long start = served.dense.size();
+        served.append(refs.data(), refs.size());
+
+        std::string reply = "OK " + std::to_string(served.dense.size());
+        for (std::map<std::pair<char, int>, ServedTrace::WarmPager>::iterator it = served.warm.begin();
+             it != served.warm.end(); ) {
+            if (it->second.frameCount < served.framesFor(it->first.second)) {
+                it = served.warm.erase(it);     // Capped below what the new pages need
+                continue;
+            }
+            served.advance(it->second, start);
+            long long before = it->second.pageFaults;
+            served.advance(it->second, served.dense.size());
+
+            reply += " " + std::string(1, it->first.first) + std::to_string(it->first.second) +
+                     "=" + std::to_string(it->second.pageFaults - before);
+            ++it;
+        }
+        return reply;
+    }
+
+    std::string faults(const std::string &name,
+                       std::istringstream &in)
+    {
+        std::unordered_map<std::string, ServedTrace>::iterator found = traces.find(name);
+        if (found == traces.end())
+            return "ERR unknown trace";
+        ServedTrace &served = found->second;
+
+        std::string algoText, frameText, startText, endText, extra;
+        in >> algoText >> frameText >> startText >> endText >> extra;
+        if (algoText.size() != 1 || !algorithmName(algoText[0]))
+            return "ERR unknown algorithm";
+        long long requested;
+        if (!parseCount(frameText, requested) || requested < 1 || requested > INT_MAX)
+            return "ERR frame count must be a number from 1 to " + std::to_string(INT_MAX);
+        int frameCount = requested;
+        char algo = std::toupper((unsigned char)algoText[0]);
+
+        long long size = served.dense.size();
+        long long a = 0, b = size;
+        if (!startText.empty() &&
+            (!parseCount(startText, a) || !parseCount(endText, b) || !extra.empty()))
+            return "ERR range needs a numeric start and end, and nothing after";
+        if (a < 0 || b < a || b > size)
+            return "ERR range out of bounds";
+
+        if (a == 0 && algo != 'O') {
+            std::pair<char, int> key(algo, frameCount);
+            std::map<std::pair<char, int>, ServedTrace::WarmPager>::iterator it = served.warm.find(key);
+            if (it == served.warm.end() || it->second.position > b) {
+                int frames = served.framesFor(frameCount);
+                ServedTrace::WarmPager fresh = {makeTier(algo, frames, nullptr), frames, 0, 0, 0};
+                it = served.warm.insert(std::make_pair(key, ServedTrace::WarmPager())).first;
+                it->second = std::move(fresh);
+            }
+            it->second.lastQuery = ++served.queries;
+            if (served.warm.size() > WARM_PAGER_LIMIT)
+                forgetOldest(served);
+            served.advance(it->second, b);
+            return "OK " + std::to_string(it->second.pageFaults);
+        }
+
+        return "OK " + std::to_string(countFaults<DenseIndex>(algo, served.framesFor(frameCount),
+                                                             served.dense.data() + a, b - a));
+    }
+};
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ * Sampled miss-ratio curves
+ *
+ * SHARDS (Waldspurger et al., FAST '15): only pages whose hash falls below
+ * a threshold are tracked, so the stack distances seen are those of a
+ * spatially sampled trace. Scaling each distance by 1/rate estimates the
+ * distance in the full trace. The fixed-size variant keeps at most
+ * maxSamples pages: when one more would be tracked, the page with the
+ * largest hash is dropped and the threshold lowered to its hash, so
+ * memory depends only on maxSamples and maxFrames, never on the trace.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_SHARDS_H
+#define PAGER_SHARDS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mrc.h"
+
+const std::uint32_t SHARDS_MODULUS = 1u << 24;     // Hashes are taken modulo this
+
+/**
+ * @brief Spread page numbers uniformly over [0, SHARDS_MODULUS).
+ */
+
+inline std::uint32_t shardsHash(int page)
+{
+    // splitmix64 finalizer
+    std::uint64_t x = (std::uint32_t)page + 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x & (SHARDS_MODULUS - 1);
+}
+
+/**
+ * @brief Approximate LRU fault counts for every frame count, fed one
+ *        reference at a time.
+ */
+
+class ShardsSampler {
+public:
+    /**
+     * @param maxFrames  Largest frame count to estimate
+     * @param rate       Starting sampling rate, in (0, 1]
+     * @param maxSamples Most pages tracked at once
+     */
+
+    ShardsSampler(int maxFrames, double rate, int maxSamples)
+        : hist(maxFrames + 2, 0), cold(0), expected(0), refCount(0),
+          threshold(std::max<std::uint64_t>(1, std::llround(rate * SHARDS_MODULUS))),
+          maxSamples(std::max(1, maxSamples)),
+          latest(4 * this->maxSamples + 16), nextIndex(0)
+    {
+        if (threshold > SHARDS_MODULUS)
+            threshold = SHARDS_MODULUS;
+        sampleRate = (double)threshold / SHARDS_MODULUS;
+    }
+
+    /**
+     * @brief Reference one page.
+     */
+
+    void access(int page)
+    {
+        refCount++;
+        expected += sampleRate;
+
+        std::uint32_t hash = shardsHash(page);
+        if (hash >= threshold)
+            return;
+
+        if (nextIndex == latestSize())
+            compact();
+
+        int now = nextIndex++;
+        std::unordered_map<int, int>::iterator it = lastSeen.find(page);
+
+        if (it == lastSeen.end()) {
+            cold++;
+            lastSeen[page] = now;
+            latest.add(now, 1);
+            byHash.push(std::make_pair(hash, page));
+            if ((int)lastSeen.size() > maxSamples)
+                lowerThreshold();
+            return;
+        }
+
+        // The other pages sampled since the last use stand for 1/rate
+        // pages each in the whole trace
+        int prev = it->second;
+        int others = latest.prefix(now) - latest.prefix(prev + 1);
+        double scaled = 1 + others / sampleRate;
+        int maxFrames = hist.size() - 2;
+        hist[scaled <= maxFrames ? (int)scaled : maxFrames + 1]++;
+
+        latest.add(prev, -1);
+        latest.add(now, 1);
+        it->second = now;
+    }
+
+    /**
+     * @brief Current sampling rate.
+     */
+
+    double rate() const
+    {
+        return sampleRate;
+    }
+
+    /**
+     * @brief Number of pages currently tracked.
+     */
+
+    int sampledPages() const
+    {
+        return lastSeen.size();
+    }
+
+    /**
+     * @brief Estimated LRU page faults for c = 1..maxFrames.
+     *
+     * The histogram is scaled from sampled references to the whole trace.
+     * Sampling may pick up a few more or fewer references than rate
+     * predicts; the difference is credited to the smallest distance, as
+     * SHARDS does, so a skewed sample does not skew every frame count.
+     *
+     * @return faults[c] for c = 1..maxFrames (faults[0] is unused)
+     */
+
+    std::vector<long long> faults() const
+    {
+        int maxFrames = hist.size() - 2;
+
+        std::vector<long long> result(maxFrames + 1, 0);
+        if (expected <= 0)
+            return result;
+
+        double farther = hist[maxFrames + 1];
+        for (int c = maxFrames; c >= 1; c--) {
+            double missRatio = std::min(1.0, (cold + farther) / expected);
+            result[c] = std::llround(missRatio * refCount);
+            farther += hist[c];
+        }
+
+        return result;
+    }
+
+private:
+    std::vector<double> hist;                   // Sampled references by scaled distance
+    double cold;                                // Sampled first references
+    double expected;                            // Sampled references expected at the running rate
+    long long refCount;                         // References seen, sampled or not
+    std::uint64_t threshold;                    // Pages with hash below this are sampled
+    double sampleRate;                          // threshold / SHARDS_MODULUS
+    int maxSamples;                             // Most pages tracked at once
+    std::unordered_map<int, int> lastSeen;      // Tracked page -> index of its latest sample
+    std::priority_queue<std::pair<std::uint32_t, int> > byHash;    // Tracked pages, largest hash on top
+    FenwickTree latest;                         // 1 at the latest sample of each tracked page
+    int nextIndex;                              // Index of the next sample
+
+    int latestSize() const
+    {
+        return 4 * maxSamples + 16;
+    }
+
+    /**
+     * @brief Drop the tracked pages with the largest hashes until the
+     *        budget is met, and lower the rate to match.
+     *
+     * Counts gathered so far are scaled down by the same factor, so they
+     * read as if the lower rate had applied from the start.
+     */
+
+    void lowerThreshold()
+    {
+        double before = sampleRate;
+
+        while ((int)lastSeen.size() > maxSamples) {
+            threshold = byHash.top().first;
+            while (!byHash.empty() && byHash.top().first >= threshold) {
+                std::unordered_map<int, int>::iterator it = lastSeen.find(byHash.top().second);
+                latest.add(it->second, -1);
+                lastSeen.erase(it);
+                byHash.pop();
+            }
+        }
+
+        sampleRate = (double)threshold / SHARDS_MODULUS;
+        double scale = sampleRate / before;
+        for (size_t d = 0; d < hist.size(); d++)
+            hist[d] *= scale;
+        cold *= scale;
+        expected *= scale;
+    }
+
+    /**
+     * @brief Renumber the tracked pages' latest samples 0..n-1 in order.
+     *
+     * Sample indices only grow, so the Fenwick tree would grow with the
+     * trace; only the relative order of the latest samples matters, and
+     * there are at most maxSamples of them.
+     */
+
+    void compact()
+    {
+        std::vector<std::pair<int, int> > order;    // (latest sample, page)
+        order.reserve(lastSeen.size());
+        for (std::unordered_map<int, int>::iterator it = lastSeen.begin(); it != lastSeen.end(); ++it)
+            order.push_back(std::make_pair(it->second, it->first));
+        std::sort(order.begin(), order.end());
+
+        latest = FenwickTree(latestSize());
+        for (size_t i = 0; i < order.size(); i++) {
+            lastSeen[order[i].second] = i;
+            latest.add(i, 1);
+        }
+        nextIndex = order.size();
+    }
+};
+
+#endif
@@ -0,0 +1,509 @@
+/**
+ * Trace input
+ *
+ * Turns the text input format into page references, either all at once
+ * (parseInputLine) or incrementally from a file (TraceReader).
+ *
+ * Input line format:
+ *   <AlgorithmCode>,<FrameCount>,<ReferenceString>
+ *
+ * A page number directly followed by 'w' is a write (e.g. "L,3,7,0w,1");
+ * the flag only matters to the cost model (see cost.h) and is skipped like
+ * any other separator everywhere else.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_TRACE_H
+#define PAGER_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "instrument.h"
+
+/**
+ * @brief A loaded trace: the input line's settings plus its references.
+ *
+ * refs points either into storage or into a memory-mapped binary trace
+ * kept alive by mapping.
+ */
+
+struct Trace {
+    char algo;                          // Algorithm code from the input
+    int frameCount;                     // Frame count from the input
+    const int *refs;                    // The page references
+    int refCount;                       // Number of page references
+    std::vector<int> storage;           // Owns refs when they were parsed or decoded
+    std::vector<char> writes;           // Write flag of each reference, if parsed (see parseWriteFlags)
+    std::shared_ptr<const void> mapping;    // Owns refs when they are mapped from a file
+
+    Trace() : algo(0), frameCount(0), refs(nullptr), refCount(0) {}
+
+    /**
+     * @brief Point refs at storage after filling it.
+     */
+
+    void useStorage()
+    {
+        refs = storage.data();
+        refCount = storage.size();
+    }
+};
+
+/**
+ * @brief Append the page numbers found in line from position i onwards.
+ *
+ * Used for the reference string of an input line, and on its own for raw
+ * traces that are nothing but page numbers.
+ *
+ * @param line Text to parse
+ * @param i    Position to start at
+ * @param refs Receives the page references
+ */
+
+inline void parseReferences(const std::string &line,
+                            size_t i,
+                            std::vector<int> &refs)
+{
+    size_t n = line.size();
+
+    // Skip separators, then read each multi-digit number into refs.
+    while (i < n) {
+
+        // Skip separators between numbers. Commas, spaces and tabs are the
+        // documented ones; anything else that is not a digit (a trailing
+        // '\r' from a CRLF file, say) is skipped the same way.
+        while (i < n && (line[i] < '0' || line[i] > '9'))
+            i++;
+
+        if (i >= n) break;
+
+        std::uint32_t val = 0;  // Unsigned, so a too-long number wraps modulo 2^32
+
+        // Convert continuous digits into an integer value.
+        while (i < n && line[i] >= '0' && line[i] <= '9') {
+            val = val * 10 + (line[i] - '0');
+            i++;
+        }
+
+        // Store parsed page reference.
+        refs.push_back((int)val);
+    }
+}
+
+/**
+ * @brief Append one flag per page number found in line from position i
+ *        onwards: 1 if the number is directly followed by 'w' or 'W'.
+ *
+ * Reads the same numbers as parseReferences(), so the flags line up with
+ * the references.
+ *
+ * @param line   Text to parse
+ * @param i      Position to start at
+ * @param writes Receives the write flags
+ */
+
+inline void parseWriteFlags(const std::string &line,
+                            size_t i,
+                            std::vector<char> &writes)
+{
+    size_t n = line.size();
+
+    while (i < n) {
+        while (i < n && (line[i] < '0' || line[i] > '9'))
+            i++;
+
+        if (i >= n) break;
+
+        while (i < n && line[i] >= '0' && line[i] <= '9')
+            i++;
+
+        writes.push_back(i < n && (line[i] == 'w' || line[i] == 'W'));
+    }
+}
+
+/**
+ * @brief Whether line is a raw trace (page numbers only) rather than an
+ *        <algo>,<frames>,<refs> scenario line.
+ */
+
+inline bool isRawTraceLine(const std::string &line)
+{
+    size_t i = line.find_first_not_of(" \t");
+    return i != std::string::npos && line[i] >= '0' && line[i] <= '9';
+}
+
+/**
+ * @brief Parse the algorithm code and frame count at the start of an
+ *        input line.
+ *
+ * @param line The input line to parse.
+ * @param algo The selected algorithm (0 if the line is empty).
+ * @param frameCount The number of frames in the cache.
+ *
+ * @return Position where the reference string starts
+ */
+
+inline size_t parseHeader(const std::string &line,
+                          char &algo,
+                          int &frameCount)
+{
+    // Reset output variables before parsing begins.
+    algo = 0;
+    frameCount = 0;
+
+    int i = 0;
+    int n = line.size();
+
+    // Skip leading whitespace before reading the algorithm code.
+    while (i < n && (line[i] == ' ' || line[i] == '\t'))
+        i++;
+
+    // First non-space character is the algorithm identifier (F, O, L, C, A, Q or U).
+    if (i < n)
+        algo = line[i++];
+    else
+        return n;   // Empty or malformed line.
+
+    // Move forward to the comma after the algorithm character.
+    while (i < n && line[i] != ',')
+        i++;
+    if (i < n) i++;   // Skip comma
+
+    // Parse the frame count (may contain multiple digits).
+    // Convert characters to an integer until hitting a non-digit.
+    while (i < n && line[i] >= '0' && line[i] <= '9') {
+        frameCount = frameCount * 10 + (line[i] - '0');
+        i++;
+    }
+
+    // Skip the comma separating frame count from the reference string.
+    if (i < n && line[i] == ',')
+        i++;
+
+    return i;
+}
+
+/**
+ * @brief Parse the input line and store the values in the given variables.
+ *
+ * @param line The input line to parse.
+ * @param algo The selected algorithm.
+ * @param frameCount The number of frames in the cache.
+ * @param refs Vector that receives the reference values.
+ */
+
+inline void parseInputLine(const std::string &line,
+                           char &algo,
+                           int &frameCount,
+                           std::vector<int> &refs)
+{
+    PAGER_PHASE(PHASE_PARSE);
+
+    refs.clear();
+    size_t i = parseHeader(line, algo, frameCount);
+
+    // Parse the rest of the line as the page-reference sequence.
+    parseReferences(line, i, refs);
+}
+
+/**
+ * @brief Reads an input file one scenario line at a time.
+ *
+ * Each non-blank line of the file is an independent scenario. The next
+ * line is read ahead so callers can tell whether more scenarios follow.
+ */
+
+class ScenarioReader {
+public:
+    /**
+     * @param filename The input file, or "-" for standard input
+     */
+
+    explicit ScenarioReader(const char *filename)
+        : in(&std::cin), pendingLine(0), lineNumber(0), havePending(false)
+    {
+        if (std::string(filename) != "-") {
+            file.open(filename);
+            if (!file) {
+                std::cerr << "Cannot open input file.\n";
+                std::exit(1);
+            }
+            in = &file;
+        }
+        fill();
+    }
+
+    /**
+     * @brief Fetch the next scenario line.
+     *
+     * @param line Receives the line
+     * @param number Receives its 1-based line number in the file
+     *
+     * @return false once the input is exhausted
+     */
+
+    bool next(std::string &line, int &number)
+    {
+        if (!havePending)
+            return false;
+
+        line.swap(pending);
+        number = pendingLine;
+        fill();
+        return true;
+    }
+
+    /**
+     * @brief Whether another scenario line follows.
+     */
+
+    bool more() const { return havePending; }
+
+private:
+    /**
+     * @brief Read ahead to the next non-blank line.
+     */
+
+    void fill()
+    {
+        havePending = false;
+        while (std::getline(*in, pending)) {
+            lineNumber++;
+            if (pending.find_first_not_of(" \t\r") != std::string::npos) {
+                pendingLine = lineNumber;
+                havePending = true;
+                return;
+            }
+        }
+    }
+
+    std::ifstream file;         // The input file (unused for stdin)
+    std::istream *in;           // Where lines come from
+    std::string pending;        // The line read ahead
+    int pendingLine;            // Line number of pending
+    int lineNumber;             // Lines read so far
+    bool havePending;           // Whether pending holds a line
+};
+
+/**
+ * @brief Incremental tokenizer over an input file.
+ *
+ * Reads the file through a fixed-size chunk buffer and hands out one page
+ * reference at a time, so memory use does not depend on the trace length.
+ * Tokenizing matches parseInputLine() exactly. Each non-blank line is one
+ * scenario; nextScenario() moves on to the following one.
+ */
+
+class TraceReader {
+public:
+    /**
+     * @param filename The input file, or "-" for standard input
+     */
+
+    explicit TraceReader(const char *filename)
+        : in(std::string(filename) == "-" ? stdin : std::fopen(filename, "rb")),
+          base(0), pos(0), len(0), atEof(false), lineNumber(1)
+    {
+        if (!in) {
+            std::cerr << "Cannot open input file.\n";
+            std::exit(1);
+        }
+    }
+
+    ~TraceReader()
+    {
+        if (in != stdin)
+            std::fclose(in);
+    }
+
+    TraceReader(const TraceReader &) = delete;
+    TraceReader &operator=(const TraceReader &) = delete;
+
+    /**
+     * @brief Skip the rest of the current line and any blank lines after it.
+     *
+     * @return false if no scenario line is left
+     */
+
+    bool nextScenario()
+    {
+        for (;;) {
+            while (peek() != -1)
+                pos++;
+            if (pos == len)
+                return false;           // End of file
+            pos++;                      // The '\n'
+            lineNumber++;
+
+            while (peek() == ' ' || peek() == '\t' || peek() == '\r')
+                pos++;
+            if (peek() != -1)
+                return true;
+            if (pos == len)
+                return false;
+        }
+    }
+
+    /**
+     * @brief Move to the first scenario line of the file.
+     *
+     * @return false if the file holds no scenario at all
+     */
+
+    bool firstScenario()
+    {
+        while (peek() == ' ' || peek() == '\t' || peek() == '\r')
+            pos++;
+        return peek() != -1 || (pos < len && nextScenario());
+    }
+
+    /**
+     * @brief Read the algorithm code and frame count at the start of the line.
+     *
+     * @param algo Receives the algorithm code
+     * @param frameCount Receives the frame count
+     */
+
+    void readHeader(char &algo, int &frameCount)
+    {
+        algo = 0;
+        frameCount = 0;
+
+        while (peek() == ' ' || peek() == '\t')
+            pos++;
+
+        if (peek() == -1)
+            return;   // Empty or malformed line.
+        algo = buffer[pos++];
+
+        while (peek() != -1 && peek() != ',')
+            pos++;
+        if (peek() == ',') pos++;
+
+        while (peek() >= '0' && peek() <= '9') {
+            frameCount = frameCount * 10 + (buffer[pos] - '0');
+            pos++;
+        }
+
+        if (peek() == ',')
+            pos++;
+    }
+
+    /**
+     * @brief Fetch the next page reference.
+     *
+     * @param page Receives the page number
+     *
+     * @return false once the end of the line has been reached
+     */
+
+    bool next(int &page)
+    {
+        int c = peek();
+        while (c != -1 && (c < '0' || c > '9')) {
+            pos++;
+            c = peek();
+        }
+        if (c == -1)
+            return false;
+
+        std::uint32_t val = 0;      // Wraps like parseReferences()
+        while (c >= '0' && c <= '9') {
+            val = val * 10 + (c - '0');
+            pos++;
+            c = peek();
+        }
+
+        page = (int)val;
+        return true;
+    }
+
+    /**
+     * @brief Whether the input starts with the given bytes. Only meaningful
+     *        before anything has been read.
+     */
+
+    bool startsWith(const char *prefix, size_t size)
+    {
+        peek();                         // Loads the first chunk
+        return len - pos >= size && std::memcmp(buffer + pos, prefix, size) == 0;
+    }
+
+    /**
+     * @brief 1-based line number of the current scenario.
+     */
+
+    int line() const { return lineNumber; }
+
+    /**
+     * @brief Byte offset in the file of the next unread character.
+     */
+
+    long long offset() const { return base + pos; }
+
+    /**
+     * @brief Continue reading from a position returned by offset().
+     *
+     * @param at   The byte offset
+     * @param line The line number at that offset
+     *
+     * @return false if the input cannot seek (standard input)
+     */
+
+    bool seek(long long at, int line)
+    {
+        if (std::fseek(in, at, SEEK_SET) != 0)
+            return false;
+        base = at;
+        pos = len = 0;
+        atEof = false;
+        lineNumber = line;
+        return true;
+    }
+
+private:
+    /**
+     * @brief Look at the current character without consuming it.
+     *
+     * @return The character, or -1 at the end of the line or file
+     *         (pos == len afterwards only at the end of the file)
+     */
+
+    int peek()
+    {
+        if (pos == len) {
+            if (atEof)
+                return -1;
+            base += len;
+            len = std::fread(buffer, 1, sizeof(buffer), in);
+            pos = 0;
+            if (len == 0) {
+                atEof = true;
+                return -1;
+            }
+        }
+        if (buffer[pos] == '\n')
+            return -1;
+        return (unsigned char)buffer[pos];
+    }
+
+    std::FILE *in;                  // The open input file
+    char buffer[1 << 16];           // Current chunk of the file
+    long long base;                 // File offset of buffer[0]
+    size_t pos;                     // Next unread byte in buffer
+    size_t len;                     // Number of valid bytes in buffer
+    bool atEof;                     // True once the file is exhausted
+    int lineNumber;                 // Line the reader is on
+};
+
+#endif
@@ -0,0 +1,312 @@
+/**
+ * Variable allocation
+ *
+ * Every other mode gives a process a fixed number of frames. Here the
+ * allocation follows the process instead:
+ *
+ *   working set  Denning's model: the resident pages are exactly those
+ *                referenced in the last tau references. A page is loaded
+ *                when referenced outside that window and dropped as soon
+ *                as its latest reference leaves it.
+ *   PFF          page-fault frequency: on each fault the fault rate is
+ *                taken as one over the references since the previous
+ *                fault. Above the upper threshold the process gets one
+ *                more frame; below the lower one every page not
+ *                referenced since the previous fault is released first;
+ *                in between the least recently used page is replaced.
+ *
+ * Both cost O(1) amortized per reference, so they run over full-length
+ * traces. Pages must be dense (see remapTrace()).
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_VARIABLE_H
+#define PAGER_VARIABLE_H
+
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "engines.h"
+#include "instrument.h"
+#include "remap.h"
+
+/**
+ * @brief Denning working-set pager with window tau.
+ *
+ * The window's references wait in a ring, so when reference t arrives the
+ * one leaving the window is at hand; its page leaves the working set if
+ * that was its latest reference.
+ */
+
+class WorkingSetPager {
+public:
+    long long pageFaults;   // References to pages outside the working set
+
+    /**
+     * @param universe Number of distinct (dense) pages
+     * @param tau      Window size in references (at least 1)
+     */
+
+    WorkingSetPager(int universe, int tau)
+        : pageFaults(0), lastRef(universe, INT_MIN), window(tau), time(0), count(0) {}
+
+    /**
+     * @brief Reference one page.
+     *
+     * @return true if the page was not in the working set
+     */
+
+    bool access(int page)
+    {
+        int t = time++;
+        int tau = window.size();
+        bool fault = lastRef[page] < t - tau;   // Not referenced in [t - tau, t)
+
+        lastRef[page] = t;
+        if (fault) {
+            pageFaults++;
+            count++;
+        }
+
+        int &slot = window[t % tau];            // Held reference t - tau until now
+        if (t >= tau && lastRef[slot] == t - tau)
+            count--;
+        slot = page;
+
+        return fault;
+    }
+
+    /**
+     * @brief Number of pages in the working set.
+     */
+
+    int resident() const { return count; }
+
+private:
+    RunVector<int> lastRef;     // Page -> its latest reference (INT_MIN = never)
+    RunVector<int> window;      // Ring: page of each of the last tau references
+    int time;                   // Index of the next reference
+    int count;                  // Pages referenced in the window
+};
+
+/**
+ * @brief Page-fault-frequency pager.
+ *
+ * Resident pages are kept in recency order, so the pages not referenced
+ * since the previous fault are a run at the back of the list; releasing
+ * them costs O(1) each, and each page is released at most once per load.
+ */
+
+class PffPager {
+public:
+    long long pageFaults;   // Page faults
+
+    /**
+     * @param universe Number of distinct (dense) pages
+     * @param lower    Fault rate, in faults per reference, below which
+     *                 pages are released
+     * @param upper    Fault rate above which the allocation grows
+     *                 (lower <= upper)
+     */
+
+    PffPager(int universe, double lower, double upper)
+        : pageFaults(0), lower(lower), upper(upper), recency(universe),
+          lastRef(universe, -1), isResident(universe, 0), time(0), lastFault(-1) {}
+
+    /**
+     * @brief Reference one page.
+     *
+     * @return true if the reference caused a page fault
+     */
+
+    bool access(int page)
+    {
+        int t = time++;
+
+        if (isResident[page]) {
+            recency.moveToFront(page);
+            lastRef[page] = t;
+            return false;
+        }
+
+        pageFaults++;
+
+        // The fault rate is 1 / gap. Above the upper threshold the page
+        // simply takes a new frame.
+        double gap = t - lastFault;
+        if (gap * lower > 1) {                  // Below the lower threshold: shrink
+            while (recency.size() > 0 && lastRef[recency.back()] < lastFault)
+                release(recency.back());
+        }
+        else if (gap * upper >= 1) {            // Within bounds: replace in place
+            if (recency.size() > 0)
+                release(recency.back());
+        }
+
+        recency.pushFront(page);
+        isResident[page] = 1;
+        lastRef[page] = t;
+        lastFault = t;
+        return true;
+    }
+
+    /**
+     * @brief Number of frames allocated.
+     */
+
+    int resident() const { return recency.size(); }
+
+private:
+    double lower;                   // Release pages below this fault rate
+    double upper;                   // Add a frame above this fault rate
+    SlotList recency;               // Resident pages, most recently used first
+    RunVector<int> lastRef;         // Page -> its latest reference
+    RunVector<char> isResident;     // Page -> whether it is resident
+    int time;                       // Index of the next reference
+    int lastFault;                  // Index of the previous fault (-1 = none yet)
+
+    void release(int page)
+    {
+        recency.remove(page);
+        isResident[page] = 0;
+    }
+};
+
+/**
+ * @brief Parse PFF thresholds given as "lower,upper".
+ *
+ * @return false unless both are numbers with 0 <= lower <= upper and
+ *         0 < upper <= 1
+ */
+
+inline bool parsePffThresholds(const std::string &spec,
+                               double &lower,
+                               double &upper)
+{
+    size_t comma = spec.find(',');
+    if (comma == std::string::npos)
+        return false;
+
+    std::string lowerText = spec.substr(0, comma);
+    std::string upperText = spec.substr(comma + 1);
+    char *rest;
+    lower = std::strtod(lowerText.c_str(), &rest);
+    if (lowerText.empty() || *rest)
+        return false;
+    upper = std::strtod(upperText.c_str(), &rest);
+    if (upperText.empty() || *rest)
+        return false;
+
+    return lower >= 0 && lower <= upper && upper > 0 && upper <= 1;
+}
+
+/**
+ * @brief The allocation at one point of a run.
+ */
+
+struct AllocationSample {
+    long long time;         // References simulated so far
+    int frames;             // Frames allocated after them
+    long long faults;       // Faults since the previous sample
+};
+
+/**
+ * @brief Results of runVariable().
+ */
+
+struct VariableResult {
+    long long faults;                       // Total page faults
+    double averageFrames;                   // Frames allocated, averaged over the references
+    int peakFrames;                         // Most frames allocated at once
+    std::vector<AllocationSample> timeline; // Every interval references, and at the end
+};
+
+/**
+ * @brief Feed a remapped trace through a variable-allocation pager.
+ *
+ * @param pager    WorkingSetPager or PffPager built for the trace
+ * @param dense[]  The remapped trace (see remapTrace())
+ * @param refCount Number of page references
+ * @param interval References between timeline samples (at least 1)
+ */
+
+template <class Engine>
+inline VariableResult runVariable(Engine &pager,
+                                  const int dense[],
+                                  int refCount,
+                                  int interval)
+{
+    PAGER_PHASE(PHASE_SIMULATE);
+
+    VariableResult result = {0, 0, 0, std::vector<AllocationSample>()};
+    long long frameSum = 0;             // Frames allocated, summed over the references
+    long long sampledFaults = 0;        // Faults up to the previous sample
+
+    for (int t = 0; t < refCount; t++) {
+        pager.access(dense[t]);
+
+        int frames = pager.resident();
+        frameSum += frames;
+        if (frames > result.peakFrames)
+            result.peakFrames = frames;
+
+        if ((t + 1) % interval == 0 || t + 1 == refCount) {
+            result.timeline.push_back(AllocationSample{t + 1, frames, pager.pageFaults - sampledFaults});
+            sampledFaults = pager.pageFaults;
+        }
+    }
+
+    result.faults = pager.pageFaults;
+    result.averageFrames = refCount ? (double)frameSum / refCount : 0;
+    return result;
+}
+
+/**
+ * @brief Run the working-set model over a trace.
+ *
+ * @param refs[]   Array of page references
+ * @param refCount Number of page references
+ * @param tau      Window size in references (at least 1)
+ * @param interval References between timeline samples (at least 1)
+ */
+
+inline VariableResult runWorkingSet(const int refs[],
+                                    int refCount,
+                                    int tau,
+                                    int interval)
+{
+    RunVector<int> dense, original;
+    int universe = remapTrace(refs, refCount, dense, original);
+
+    WorkingSetPager pager(universe, tau);
+    return runVariable(pager, dense.data(), refCount, interval);
+}
+
+/**
+ * @brief Run page-fault-frequency allocation over a trace.
+ *
+ * @param refs[]   Array of page references
+ * @param refCount Number of page references
+ * @param lower    Fault rate below which pages are released
+ * @param upper    Fault rate above which the allocation grows
+ * @param interval References between timeline samples (at least 1)
+ */
+
+inline VariableResult runPff(const int refs[],
+                             int refCount,
+                             double lower,
+                             double upper,
+                             int interval)
+{
+    RunVector<int> dense, original;
+    int universe = remapTrace(refs, refCount, dense, original);
+
+    PffPager pager(universe, lower, upper);
+    return runVariable(pager, dense.data(), refCount, interval);
+}
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * Windowed OPT
+ *
+ * OPT needs the whole future of the trace. WindowedOptPager runs Belady's
+ * rule over a streamed trace instead, seeing only the next W references:
+ * they wait in a ring buffer before being simulated, and a page that does
+ * not occur in the window counts as never used again. Memory is
+ * O(W + frames) whatever the trace length, and the result approaches OPT
+ * as W grows (it is exactly OPT once W covers the rest of the trace).
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_WINDOW_H
+#define PAGER_WINDOW_H
+
+#include <climits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pager.h"
+
+const long long WINDOW_NEVER = LLONG_MAX;   // Next use of a page not seen in the window
+
+/**
+ * @brief OPT replacement keyed by next uses inside a look-ahead window.
+ *
+ * Like OptPolicy, resident frames sit in a max-heap of (next use, -frame)
+ * with stale entries skipped, so ties among pages never used again go to
+ * the lowest frame. Next uses come from the window's nextSame links; a
+ * page keyed WINDOW_NEVER is re-keyed by reveal() when its next use enters
+ * the window.
+ */
+
+struct WindowedOptPolicy : PolicyBase {
+    typedef std::priority_queue<std::pair<long long, int>, RunVector<std::pair<long long, int> > > Heap;
+
+    RunVector<long long> nextOf;                // Next use of the page in each frame (-1 = empty)
+    RunVector<int> pageOf;                      // Page in each frame
+    RunHashMap<int, int> unseen;                // Resident page keyed WINDOW_NEVER -> frame
+    const RunVector<long long> *nextSame;       // Ring: next use of the reference at each position
+    Heap byNextUse;                             // (next use, -frame), may hold stale entries
+
+    /**
+     * @param frameCount Number of frames that can be used
+     * @param nextSame   The window's ring of next uses, indexed by time modulo its size
+     */
+
+    WindowedOptPolicy(int frameCount, const RunVector<long long> *nextSame)
+        : nextOf(frameCount, -1), pageOf(frameCount, -1), nextSame(nextSame) {}
+
+    void onHit(int slot, long long t)
+    {
+        setNext(slot, (*nextSame)[t % nextSame->size()]);
+    }
+
+    int chooseVictim(int, long long)
+    {
+        while (nextOf[-byNextUse.top().second] != byNextUse.top().first)
+            byNextUse.pop();
+        int slot = -byNextUse.top().second;
+        byNextUse.pop();
+        if (nextOf[slot] == WINDOW_NEVER)
+            unseen.erase(pageOf[slot]);
+        return slot;
+    }
+
+    void onMiss(int slot, int page, long long t)
+    {
+        pageOf[slot] = page;
+        setNext(slot, (*nextSame)[t % nextSame->size()]);
+    }
+
+    /**
+     * @brief A page has entered the window at time t; if it is resident
+     *        and keyed as never used again, t is its next use.
+     */
+
+    void reveal(int page, long long t)
+    {
+        RunHashMap<int, int>::iterator it = unseen.find(page);
+        if (it != unseen.end())
+            setNext(it->second, t);
+    }
+
+private:
+    void setNext(int slot, long long next)
+    {
+        if (nextOf[slot] == WINDOW_NEVER)
+            unseen.erase(pageOf[slot]);
+        if (next == WINDOW_NEVER)
+            unseen[pageOf[slot]] = slot;
+
+        nextOf[slot] = next;
+        byNextUse.push(std::make_pair(next, -slot));
+
+        // Stale entries pile up on hits; rebuild from the live keys when
+        // they outnumber the frames
+        if (byNextUse.size() > 2 * nextOf.size() + 16) {
+            Heap live;
+            for (size_t i = 0; i < nextOf.size(); i++)
+                if (nextOf[i] != -1)
+                    live.push(std::make_pair(nextOf[i], -(int)i));
+            byNextUse.swap(live);
+        }
+    }
+};
+
+/**
+ * @brief OPT over a streamed trace with a look-ahead of W references.
+ *
+ * access() only queues a reference; the reference W places earlier is
+ * simulated once it has its full window. Call finish() after the last
+ * reference to simulate the ones still queued.
+ */
+
+class WindowedOptPager {
+public:
+    long long pageFaults;   // Faults among the references simulated so far
+
+    /**
+     * @param frameCount Number of frames that can be used
+     * @param window     References visible beyond the current one (W >= 0)
+     */
+
+    WindowedOptPager(int frameCount, int window)
+        : pageFaults(0), pages(window + 1), nextSame(window + 1),
+          pager(frameCount, &nextSame), head(0), tail(0) {}
+
+    /**
+     * @brief Queue one reference, simulating the oldest queued one if the
+     *        window is full.
+     */
+
+    void access(int page)
+    {
+        if (tail - head == (long long)pages.size())
+            step();
+
+        long long t = tail++;
+        size_t at = t % pages.size();
+        pages[at] = page;
+        nextSame[at] = WINDOW_NEVER;
+
+        // Link the previous occurrence in the window to this one, or tell
+        // the policy that a page it thought unused has a next use after all
+        std::pair<RunHashMap<int, long long>::iterator, bool> last =
+            latest.insert(std::make_pair(page, t));
+        if (last.second)
+            pager.policy.reveal(page, t);
+        else {
+            nextSame[last.first->second % pages.size()] = t;
+            last.first->second = t;
+        }
+    }
+
+    /**
+     * @brief Simulate every queued reference.
+     *
+     * @return Total page faults
+     */
+
+    long long finish()
+    {
+        while (head < tail)
+            step();
+        return pageFaults;
+    }
+
+private:
+    RunVector<int> pages;                           // Ring: queued references
+    RunVector<long long> nextSame;                  // Ring: next use of each queued reference
+    Pager<WindowedOptPolicy> pager;                 // Simulates references as they leave the window
+    RunHashMap<int, long long> latest;              // Page -> its latest time in the window
+    long long head;                                 // Time of the oldest queued reference
+    long long tail;                                 // Time of the next reference to queue
+
+    /**
+     * @brief Simulate the oldest queued reference.
+     */
+
+    void step()
+    {
+        int page = pages[head % pages.size()];
+
+        RunHashMap<int, long long>::iterator it = latest.find(page);
+        if (it->second == head)             // No later occurrence is queued
+            latest.erase(it);
+
+        pager.access(page);
+        pageFaults = pager.pageFaults;
+        head++;
+    }
+};
+
+#endif
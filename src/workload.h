@@ -0,0 +1,123 @@
+/**
+ * Synthetic workloads
+ *
+ * Generators for page-reference traces with a controlled page-universe
+ * size and length, used by the benchmark harness.
+ *
+ * @author Connor Parr
+ * @author Seth Garner
+ */
+
+#ifndef PAGER_WORKLOAD_H
+#define PAGER_WORKLOAD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Names of the workloads generateWorkload() understands.
+ */
+
+inline std::vector<std::string> workloadNames()
+{
+    return std::vector<std::string>{"uniform", "zipf", "scan", "loop", "phase"};
+}
+
+/**
+ * @brief Generate a synthetic trace.
+ *
+ * - uniform: every page equally likely
+ * - zipf:    page of rank k drawn with probability proportional to 1/k^0.9
+ * - scan:    half the references hit a small hot set, the other half walk
+ *            through the whole universe in order
+ * - loop:    pages 0..universe-1 in order, over and over
+ * - phase:   a working set of universe/8 pages, drawn uniformly, that moves
+ *            to a different part of the universe eight times over the trace
+ *
+ * @param name     Workload name (see workloadNames())
+ * @param universe Number of distinct pages that may appear
+ * @param length   Number of references to generate
+ * @param seed     Random seed, so runs are repeatable
+ * @param refs     Receives the trace
+ *
+ * @return false for an unknown workload name
+ */
+
+inline bool generateWorkload(const std::string &name,
+                             int universe,
+                             int length,
+                             std::uint64_t seed,
+                             std::vector<int> &refs)
+{
+    std::mt19937_64 rng(seed);
+    refs.resize(length);
+
+    if (name == "uniform") {
+        std::uniform_int_distribution<int> page(0, universe - 1);
+        for (int t = 0; t < length; t++)
+            refs[t] = page(rng);
+    }
+    else if (name == "zipf") {
+        // Cumulative weights over ranks, sampled by binary search
+        std::vector<double> cdf(universe);
+        double total = 0;
+        for (int k = 0; k < universe; k++) {
+            total += 1.0 / std::pow(k + 1, 0.9);
+            cdf[k] = total;
+        }
+
+        // Scatter the ranks so hot pages are not simply the small numbers
+        std::vector<int> pageOfRank(universe);
+        for (int k = 0; k < universe; k++)
+            pageOfRank[k] = k;
+        std::shuffle(pageOfRank.begin(), pageOfRank.end(), rng);
+
+        std::uniform_real_distribution<double> u(0, total);
+        for (int t = 0; t < length; t++) {
+            int k = std::lower_bound(cdf.begin(), cdf.end(), u(rng)) - cdf.begin();
+            refs[t] = pageOfRank[k < universe ? k : universe - 1];
+        }
+    }
+    else if (name == "scan") {
+        int hot = std::max(1, universe / 16);
+        std::uniform_int_distribution<int> hotPage(0, hot - 1);
+        std::bernoulli_distribution coin(0.5);
+        int cursor = 0;
+        for (int t = 0; t < length; t++) {
+            if (coin(rng)) {
+                refs[t] = hotPage(rng);
+            }
+            else {
+                refs[t] = cursor;
+                cursor = (cursor + 1) % universe;
+            }
+        }
+    }
+    else if (name == "loop") {
+        for (int t = 0; t < length; t++)
+            refs[t] = t % universe;
+    }
+    else if (name == "phase") {
+        int setSize = std::max(1, universe / 8);
+        int phaseLength = std::max(1, length / 8);
+        std::uniform_int_distribution<int> member(0, setSize - 1);
+        std::uniform_int_distribution<int> base(0, universe - setSize);
+        int start = base(rng);
+        for (int t = 0; t < length; t++) {
+            if (t > 0 && t % phaseLength == 0)
+                start = base(rng);
+            refs[t] = start + member(rng);
+        }
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+#endif